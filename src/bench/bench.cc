@@ -0,0 +1,495 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ /**
+  * @brief Controller benchmarks.
+  *
+  * Builds synthetic procfs trees and times the controller on them, run
+  * with "make bench".
+  *
+  * Every scenario runs on its own child process, the controller is a singleton
+  * and must be created after the procfs path is set.
+  *
+  * Usage: bench [-r rounds] [-d dir] [-k] [-g] [-b bursts] [-c children] [-l lifetime] [-w window] [-o file] [-B baseline] [-t threshold] [-p recording [-a agents]] [count...]
+  *
+  *   -r rounds	Rounds for each measure (default 5).
+  *   -d dir	Directory for the synthetic trees (default a temporary one).
+  *   -k		Keep the synthetic trees.
+  *   -g		Only generate the synthetic trees.
+  *   -b bursts	Bursts of children for the exec storm (default 20, 0 to skip).
+  *   -c children	Children per burst (default 100).
+  *   -l lifetime	Children lifetime in milliseconds (default 10).
+  *   -w window	Grace window for the exec storm in milliseconds (default 0).
+  *   -p recording	Only time the replay of a process recording.
+  *   -a agents	Xml file with the agents evaluated on the replay.
+  *   -o file	Save the measures, to be used as a baseline.
+  *   -B baseline	Fail when a measure is slower than the baseline.
+  *   -t threshold	Tolerance over the baseline in percent (default 20).
+  *
+  */
+
+ #include "private.h"
+ #include <unistd.h>
+ #include <sys/wait.h>
+ #include <algorithm>
+ #include <chrono>
+ #include <cstdio>
+ #include <cstdlib>
+ #include <cstring>
+ #include <climits>
+ #include <iostream>
+ #include <system_error>
+
+ using namespace std;
+ using namespace Udjat;
+
+ namespace Udjat {
+
+	std::map<std::pair<std::string,size_t>,double> Process::Benchmark::baseline;
+	double Process::Benchmark::threshold = 20;
+	const char * Process::Benchmark::output = nullptr;
+
+	/// @brief Measures above the baseline threshold on this process.
+	static unsigned int regressions = 0;
+
+	Process::Benchmark::Benchmark(const std::string &p, size_t c, unsigned int r) : path(p), count(c), rounds(r) {
+	}
+
+	void Process::Benchmark::load(const char *filename) {
+
+		FILE *file = fopen(filename,"r");
+		if(!file) {
+			throw system_error(errno, system_category(), filename);
+		}
+
+		char name[64];
+		size_t count;
+		double value;
+
+		while(fscanf(file,"%63s %zu %lf",name,&count,&value) == 3) {
+			baseline[make_pair(string{name},count)] = value;
+		}
+
+		fclose(file);
+
+		if(baseline.empty()) {
+			throw runtime_error(string{"No measures in "} + filename);
+		}
+
+	}
+
+	int Process::Benchmark::isolated(const std::function<void()> &scenario) noexcept {
+
+		fflush(stdout);
+
+		pid_t pid = fork();
+
+		if(pid < 0) {
+			perror("fork");
+			return 1;
+		}
+
+		if(!pid) {
+
+			int rc = 0;
+
+			try {
+
+				scenario();
+				rc = (regressions ? 2 : 0);
+
+			} catch(const exception &e) {
+
+				cerr << "Error '" << e.what() << "' running benchmarks" << endl;
+				rc = 1;
+
+			}
+
+			fflush(stdout);
+
+			// Skip the singleton destructors, the controller threads are still running.
+			_exit(rc);
+
+		}
+
+		int status;
+		while(waitpid(pid,&status,0) < 0) {
+			if(errno != EINTR) {
+				perror("waitpid");
+				return 1;
+			}
+		}
+
+		return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+
+	}
+
+	template <typename S, typename T>
+	void Process::Benchmark::measure(const char *name, S setup, T call) {
+
+		double best = 0;
+		double total = 0;
+
+		for(unsigned int round = 0; round < rounds; round++) {
+
+			setup();
+
+			auto begin = chrono::steady_clock::now();
+			call();
+			double elapsed = chrono::duration<double,milli>(chrono::steady_clock::now() - begin).count();
+
+			if(!round || elapsed < best) {
+				best = elapsed;
+			}
+			total += elapsed;
+
+		}
+
+		double value = (best * 1000000) / count;
+
+		printf("%-12s %8zu %12.3f %12.3f %12.1f\n",name,count,best,total/rounds,value);
+		fflush(stdout);
+
+		if(output) {
+			FILE *file = fopen(output,"a");
+			if(!file) {
+				throw system_error(errno, system_category(), output);
+			}
+			fprintf(file,"%s %zu %.1f\n",name,count,value);
+			fclose(file);
+		}
+
+		auto reference = baseline.find(make_pair(string{name},count));
+		if(reference != baseline.end() && value > reference->second * (1 + (threshold / 100))) {
+			fprintf(
+				stderr,
+				"%s: %.1f ns/process with %zu processes, %.1f%% above the baseline\n",
+				name,
+				value,
+				count,
+				((value / reference->second) - 1) * 100
+			);
+			regressions++;
+		}
+
+	}
+
+	void Process::Benchmark::wait(Controller &controller) {
+		while(controller.startup.tasks.load()) {
+			usleep(1000);
+		}
+	}
+
+	void Process::Benchmark::run() {
+
+		Identifier::procfs(path.c_str());
+
+		Controller &controller = Controller::getInstance();
+		wait(controller);
+
+		// Events from the real process table would disturb the measures.
+		controller.MainLoop::Handler::close();
+
+		std::vector<pid_t> pids;
+
+		measure("load",[]{},[&pids]{
+			Controller::load(pids);
+		});
+
+		if(pids.size() != count) {
+			throw runtime_error(string{"Unexpected process count on "} + path);
+		}
+
+		measure("reload-cold",[&controller]{
+			controller.clear();
+		},[&controller]{
+			controller.reload();
+		});
+
+		measure("reload",[]{},[&controller]{
+			controller.reload();
+		});
+
+		measure("populate",[&controller]{
+			controller.clear();
+		},[&controller]{
+			controller.populate(0);
+			wait(controller);
+		});
+
+		measure("refresh",[]{},[&controller]{
+			controller.refresh();
+		});
+
+		unsigned long long checksum = 0;
+		measure("stat",[]{},[&pids,&checksum]{
+			for(auto pid : pids) {
+				Identifier::Stat stat{pid};
+				checksum += stat.utime;
+			}
+		});
+
+		// The matcher never dereferences the agents, use distinct addresses as tokens.
+		static const char * names[] = {
+			"httpd", "sshd", "postgres", "python3", "java", "nginx", "bash", "systemd-journald"
+		};
+
+		std::vector<char> tokens(256);
+		Matcher matcher;
+		for(size_t ix = 0; ix < 64; ix++) {
+
+			const char *name = names[ix % (sizeof(names)/sizeof(names[0]))];
+			string value;
+
+			value = string{"/usr/bin/"} + name + "-" + to_string(ix);
+			matcher.insert(reinterpret_cast<Agent *>(&tokens[ix]),Matcher::ExeName,value.c_str());
+
+			value = string{"*/etc/"} + name + "/" + to_string(ix) + ".conf*";
+			matcher.insert(reinterpret_cast<Agent *>(&tokens[64+ix]),Matcher::CmdLine,value.c_str());
+
+			value = string{"*"} + name + "-" + to_string(ix);
+			matcher.insert(reinterpret_cast<Agent *>(&tokens[128+ix]),Matcher::ExeName,value.c_str());
+
+			matcher.insert(reinterpret_cast<Agent *>(&tokens[192+ix]),Matcher::Comm,name);
+
+		}
+
+		size_t matches = 0;
+		measure("match",[]{},[&controller,&matcher,&matches]{
+			lock_guard<Controller::Guard> lock(Controller::guard);
+			std::vector<Agent *> agents;
+			for(auto &identifier : controller.identifiers) {
+				Matcher::Subject subject{identifier};
+				matcher.probe(subject,agents);
+				matches += agents.size();
+				agents.clear();
+			}
+		});
+
+		if(!(checksum && matches)) {
+			throw runtime_error("Unexpected results on synthetic procfs");
+		}
+
+	}
+
+ }
+
+ int main(int argc, char **argv) {
+
+	// Exec storm child.
+	if(argc == 3 && !strcmp(argv[1],"-x")) {
+		usleep(atoi(argv[2]) * 1000);
+		return 0;
+	}
+
+	unsigned int rounds = 5;
+	unsigned int bursts = 20;
+	unsigned int children = 100;
+	unsigned int lifetime = 10;
+	unsigned long window = 0;
+	string root;
+	bool keep = false;
+	bool generate = false;
+	const char *recording = nullptr;
+	const char *agents = nullptr;
+	const char *reference = nullptr;
+
+	int opt;
+	while( (opt = getopt(argc,argv,"r:d:kgb:c:l:w:p:a:o:B:t:")) != -1) {
+		switch(opt) {
+		case 'r':
+			rounds = (unsigned int) atoi(optarg);
+			break;
+
+		case 'd':
+			root = optarg;
+			break;
+
+		case 'k':
+			keep = true;
+			break;
+
+		case 'g':
+			generate = keep = true;
+			break;
+
+		case 'b':
+			bursts = (unsigned int) atoi(optarg);
+			break;
+
+		case 'c':
+			children = (unsigned int) atoi(optarg);
+			break;
+
+		case 'l':
+			lifetime = (unsigned int) atoi(optarg);
+			break;
+
+		case 'w':
+			window = (unsigned long) atol(optarg);
+			break;
+
+		case 'p':
+			recording = optarg;
+			break;
+
+		case 'a':
+			agents = optarg;
+			break;
+
+		case 'o':
+			Process::Benchmark::output = optarg;
+			break;
+
+		case 'B':
+			reference = optarg;
+			break;
+
+		case 't':
+			Process::Benchmark::threshold = atof(optarg);
+			break;
+
+		default:
+			cerr << "Usage: " << argv[0] << " [-r rounds] [-d dir] [-k] [-g] [-b bursts] [-c children] [-l lifetime] [-w window] [-o file] [-B baseline] [-t threshold] [-p recording [-a agents]] [count...]" << endl;
+			return 1;
+		}
+	}
+
+	if(recording) {
+
+		try {
+
+			Process::Benchmark::replay(recording,agents);
+
+		} catch(const exception &e) {
+
+			cerr << "Error '" << e.what() << "' replaying " << recording << endl;
+			return 1;
+
+		}
+
+		return 0;
+
+	}
+
+	try {
+
+		if(reference) {
+			Process::Benchmark::load(reference);
+		}
+
+		// Started empty, the scenarios append their measures.
+		if(Process::Benchmark::output) {
+			FILE *file = fopen(Process::Benchmark::output,"w");
+			if(!file) {
+				throw system_error(errno, system_category(), Process::Benchmark::output);
+			}
+			fclose(file);
+		}
+
+	} catch(const exception &e) {
+
+		cerr << "Error '" << e.what() << "' loading the baseline" << endl;
+		return 1;
+
+	}
+
+	std::vector<size_t> counts;
+	for(int arg = optind; arg < argc; arg++) {
+		counts.push_back((size_t) atol(argv[arg]));
+	}
+
+	if(counts.empty()) {
+		counts = { 1000, 10000, 100000 };
+	}
+
+	if(!rounds) {
+		rounds = 1;
+	}
+
+	bool temporary = root.empty();
+	if(temporary) {
+		char name[] = "/tmp/udjat-procfs-XXXXXX";
+		if(!mkdtemp(name)) {
+			perror("mkdtemp");
+			return 1;
+		}
+		root = name;
+	}
+
+	int rc = 0;
+
+	try {
+
+		// On the real process table, before the synthetic trees.
+		if(bursts && children && !generate) {
+
+			char child[PATH_MAX];
+			ssize_t sz = readlink("/proc/self/exe",child,sizeof(child)-1);
+			if(sz < 0) {
+				throw system_error(errno, system_category(), "Can't get benchmark path");
+			}
+			child[sz] = 0;
+
+			rc = max(rc,Process::Benchmark::isolated([&]{
+				Process::Benchmark::storm(bursts,children,lifetime,child,window);
+			}));
+
+		}
+
+		if(!generate) {
+			printf("%-12s %8s %12s %12s %12s\n","measure","count","best(ms)","mean(ms)","ns/process");
+		}
+
+		for(auto count : counts) {
+
+			string path{root + "/" + to_string(count)};
+
+			Process::Benchmark::generate(path,count);
+
+			if(generate) {
+				cout << path << endl;
+				continue;
+			}
+
+			rc = max(rc,Process::Benchmark::isolated([&]{
+				Process::Benchmark(path,count,rounds).run();
+			}));
+
+			if(!keep) {
+				Process::Benchmark::remove(path);
+			}
+
+		}
+
+	} catch(const exception &e) {
+
+		cerr << "Error '" << e.what() << "' running benchmarks" << endl;
+		rc = 1;
+
+	}
+
+	if(temporary && !keep) {
+		Process::Benchmark::remove(root);
+	}
+
+	return rc;
+
+ }
@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ #pragma once
+
+ #include <config.h>
+ #include <udjat/defs.h>
+ #include <controller.h>
+ #include <functional>
+ #include <map>
+ #include <string>
+ #include <utility>
+ #include <vector>
+
+ namespace Udjat {
+
+	namespace Process {
+
+		/// @brief Controller benchmarks on a synthetic procfs.
+		class Benchmark {
+		private:
+
+			/// @brief The procfs tree.
+			std::string path;
+
+			/// @brief Number of processes in the tree.
+			size_t count;
+
+			/// @brief Number of rounds for each measure.
+			unsigned int rounds;
+
+			/// @brief Run and report a measure.
+			/// @param name The measure name.
+			/// @param setup Called before each round (not timed).
+			/// @param call The measured code.
+			template <typename S, typename T>
+			void measure(const char *name, S setup, T call);
+
+			/// @brief Wait for the controller initial population.
+			static void wait(Controller &controller);
+
+			/// @brief Best ns/process of the reference run, by measure and count.
+			static std::map<std::pair<std::string,size_t>,double> baseline;
+
+		public:
+
+			/// @brief Tolerance over the baseline, in percent.
+			static double threshold;
+
+			/// @brief File receiving the measures, to be used as a new baseline.
+			static const char *output;
+
+			/// @brief Load the baseline saved by a previous run.
+			/// @param filename The file written with -o.
+			static void load(const char *filename);
+
+			/// @brief Run a scenario on a child process.
+			/// @param scenario The scenario, gets a fresh controller singleton.
+			/// @return 0 on success, 1 on error, 2 on a measure above the baseline threshold.
+			static int isolated(const std::function<void()> &scenario) noexcept;
+
+			/// @brief Build a synthetic procfs tree.
+			/// @param path The tree root (created if needed).
+			/// @param count Number of processes.
+			static void generate(const std::string &path, size_t count);
+
+			/// @brief Remove a synthetic procfs tree.
+			static void remove(const std::string &path) noexcept;
+
+			/// @brief Time exec to agent bind on bursts of short lived children.
+			/// @param bursts Number of bursts.
+			/// @param children Children per burst.
+			/// @param lifetime Children lifetime in milliseconds.
+			/// @param child The child program, should exit after "-x lifetime".
+			/// @param window The grace window in milliseconds.
+			static void storm(unsigned int bursts, unsigned int children, unsigned int lifetime, const char *child, unsigned long window);
+
+			/// @brief Time the replay of a recording (see [process] recorder).
+			/// @param path The recording.
+			/// @param agents Optional xml file with agent definitions to evaluate.
+			static void replay(const char *path, const char *agents);
+
+			Benchmark(const std::string &path, size_t count, unsigned int rounds);
+
+			/// @brief Time load, reload, refresh, stat parsing and agent matching.
+			void run();
+
+		};
+
+	}
+
+ }
@@ -0,0 +1,148 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ #include "private.h"
+ #include <unistd.h>
+ #include <fcntl.h>
+ #include <ftw.h>
+ #include <sys/stat.h>
+ #include <sys/types.h>
+ #include <cstdio>
+ #include <cstring>
+ #include <system_error>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	/// @brief Number of distinct executables in the synthetic tree.
+	static const unsigned int executables = 64;
+
+	static const char * names[] = {
+		"httpd", "sshd", "postgres", "python3", "java", "nginx", "bash", "systemd-journald"
+	};
+
+	static void save(const string &filename, const char *contents, size_t length) {
+
+		int fd = open(filename.c_str(),O_WRONLY|O_CREAT|O_TRUNC,0644);
+		if(fd < 0) {
+			throw system_error(errno, system_category(), filename);
+		}
+
+		ssize_t sz = write(fd,contents,length);
+		::close(fd);
+
+		if(sz != (ssize_t) length) {
+			throw system_error(errno, system_category(), filename);
+		}
+
+	}
+
+	void Process::Benchmark::generate(const std::string &path, size_t count) {
+
+		if(mkdir(path.c_str(),0755) && errno != EEXIST) {
+			throw system_error(errno, system_category(), path);
+		}
+
+		char buffer[1024];
+
+		// System wide stat, for the boot time.
+		{
+			int length = snprintf(
+				buffer,
+				sizeof(buffer),
+				"cpu  1000 0 1000 100000 0 0 0 0 0 0\nbtime %lu\n",
+				(unsigned long) (time(nullptr) - 86400)
+			);
+			save(path + "/stat",buffer,length);
+		}
+
+		uint32_t seed = 1;
+		auto random = [&seed]() {
+			seed = seed * 1103515245 + 12345;
+			return (seed >> 16) & 0x7fff;
+		};
+
+		for(size_t ix = 0; ix < count; ix++) {
+
+			unsigned int pid = (unsigned int) (ix + 1);
+			unsigned int exe = random() % executables;
+			const char *name = names[exe % (sizeof(names)/sizeof(names[0]))];
+
+			string dir{path};
+			dir += "/" + to_string(pid);
+
+			if(mkdir(dir.c_str(),0755) && errno != EEXIST) {
+				throw system_error(errno, system_category(), dir);
+			}
+
+			// Fields 3 to 52, see proc(5).
+			int length = snprintf(
+				buffer,
+				sizeof(buffer),
+				"%u (%s) S 1 %u %u 0 -1 4194560 %u 0 %u 0 %u %u 0 0 20 0 1 0 %u %lu %u 18446744073709551615"
+				" 1 1 0 0 0 0 0 0 0 0 0 0 17 0 0 0 %u 0 0 0 0 0 0 0 0 0 0\n",
+				pid,
+				name,
+				pid,
+				pid,
+				random(),				// minflt
+				random() % 100,			// majflt
+				random(),				// utime
+				random() % 1000,		// stime
+				100 + pid,				// starttime
+				(unsigned long) (random() + 1) * 4096 * 64,	// vsize
+				random() % 8192,		// rss
+				random() % 100			// blkio_ticks
+			);
+			save(dir + "/stat",buffer,length);
+
+			length = snprintf(buffer,sizeof(buffer),"%s\n",name);
+			save(dir + "/comm",buffer,length);
+
+			length = snprintf(buffer,sizeof(buffer),"%s%c--config%c/etc/%s/%u.conf%c",name,0,0,name,exe,0);
+			save(dir + "/cmdline",buffer,length);
+
+			snprintf(buffer,sizeof(buffer),"/usr/bin/%s-%u",name,exe);
+			string link{dir + "/exe"};
+			unlink(link.c_str());
+			if(symlink(buffer,link.c_str())) {
+				throw system_error(errno, system_category(), link);
+			}
+
+		}
+
+	}
+
+	void Process::Benchmark::remove(const std::string &path) noexcept {
+
+		nftw(
+			path.c_str(),
+			[](const char *name, const struct stat *, int, struct FTW *) {
+				::remove(name);
+				return 0;
+			},
+			64,
+			FTW_DEPTH|FTW_PHYS
+		);
+
+	}
+
+ }
@@ -0,0 +1,118 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ #include "private.h"
+ #include <udjat/process/agent.h>
+ #include <pugixml.hpp>
+ #include <algorithm>
+ #include <chrono>
+ #include <cstdio>
+ #include <memory>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	void Process::Benchmark::replay(const char *path, const char *definitions) {
+
+		Controller &controller = Controller::getInstance();
+		wait(controller);
+
+		// Events from the real process table would disturb the replay.
+		controller.MainLoop::Handler::close();
+		controller.clear();
+		controller.system.running = controller.system.idle = 0;
+
+		// Agents to evaluate, from an xml file with the same nodes as the service.
+		pugi::xml_document document;
+		vector<shared_ptr<Abstract::Agent>> agents;
+
+		if(definitions) {
+
+			auto result = document.load_file(definitions);
+			if(!result) {
+				throw runtime_error(string{"Can't load "} + definitions + ": " + result.description());
+			}
+
+			for(auto node : document.document_element().children()) {
+				auto agent = Process::Agent::AgentFactory(node);
+				if(agent) {
+					agent->start();
+					agents.push_back(agent);
+				}
+			}
+
+		}
+
+		// Decode.
+		vector<Recording::Generation> generations;
+		auto begin = chrono::steady_clock::now();
+		{
+			Recording::Reader reader{path};
+			Recording::Generation generation;
+			while(reader.read(generation)) {
+				generations.push_back(generation);
+			}
+		}
+		double decode = chrono::duration<double,milli>(chrono::steady_clock::now() - begin).count();
+
+		if(generations.empty()) {
+			throw runtime_error(string{"No generations in "} + path);
+		}
+
+		// Replay.
+		vector<double> latencies;
+		latencies.reserve(generations.size());
+
+		for(auto &generation : generations) {
+			auto start = chrono::steady_clock::now();
+			controller.replay(generation);
+			latencies.push_back(chrono::duration<double,micro>(chrono::steady_clock::now() - start).count());
+		}
+
+		double total = 0;
+		for(auto latency : latencies) {
+			total += latency;
+		}
+
+		sort(latencies.begin(),latencies.end());
+
+		auto percentile = [&latencies](double p) {
+			return latencies[std::min(latencies.size() - 1,(size_t) (p * latencies.size()))];
+		};
+
+		printf("%-12s %12zu\n","generations",generations.size());
+		printf("%-12s %12zu\n","agents",agents.size());
+		printf("%-12s %12zu\n","identifiers",controller.size());
+		printf("%-12s %12.3f\n","decode(ms)",decode);
+		printf("%-12s %12.3f\n","replay(ms)",total / 1000);
+		printf("%-12s %12.1f\n","mean(us)",total / latencies.size());
+		printf("%-12s %12.1f\n","p50(us)",percentile(0.50));
+		printf("%-12s %12.1f\n","p99(us)",percentile(0.99));
+		printf("%-12s %12.1f\n","max(us)",latencies.back());
+		fflush(stdout);
+
+		for(auto agent : agents) {
+			agent->stop();
+		}
+
+	}
+
+ }
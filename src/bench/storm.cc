@@ -0,0 +1,258 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ #include "private.h"
+ #include <unistd.h>
+ #include <poll.h>
+ #include <spawn.h>
+ #include <sys/wait.h>
+ #include <linux/connector.h>
+ #include <linux/netlink.h>
+ #include <linux/cn_proc.h>
+ #include <algorithm>
+ #include <chrono>
+ #include <cstdio>
+ #include <cstring>
+ #include <unordered_map>
+
+ using namespace std;
+
+ extern char **environ;
+
+ namespace Udjat {
+
+	typedef chrono::steady_clock::time_point TimePoint;
+
+	/// @brief Agent recording the delay between the child exec and the bind.
+	class Probe : public Process::Agent {
+	private:
+		const char *exename;
+
+	public:
+
+		/// @brief Exec time of the children not yet bound, by pid.
+		unordered_map<pid_t,TimePoint> pending;
+
+		/// @brief Exec to bind delays, in microseconds.
+		vector<double> latencies;
+
+		Probe(const char *e) : exename(e) {
+		}
+
+	protected:
+
+		bool probe(const char *name) const noexcept override {
+			return strcmp(name,exename) == 0;
+		}
+
+		void set(Process::Identifier *identifier) override {
+
+			if(!identifier) {
+				return;
+			}
+
+			auto now = chrono::steady_clock::now();
+			auto it = pending.find(identifier->getPid());
+			if(it != pending.end()) {
+				latencies.push_back(chrono::duration<double,micro>(now - it->second).count());
+				pending.erase(it);
+			}
+
+			// Keep unbound, all the children must be probed.
+
+		}
+
+	};
+
+	void Process::Benchmark::storm(unsigned int bursts, unsigned int children, unsigned int lifetime, const char *child, unsigned long window) {
+
+		Identifier::procfs("/proc");
+
+		Controller &controller = Controller::getInstance();
+		wait(controller);
+
+		controller.clear();
+		controller.reload();
+
+		controller.deferred.window = window;
+		auto coalesced = Controller::metrics.coalesced.load();
+		auto merged = Controller::metrics.merged.load();
+		auto overloads = Controller::metrics.overloads.load();
+
+		// Without the kernel connector the events are injected after the spawn and the reap.
+		bool injected = (controller.fd < 0);
+
+		Probe probe{child};
+		controller.insert(&probe);
+
+		string life{to_string(lifetime)};
+		char * const argv[] = { (char *) child, (char *) "-x", (char *) life.c_str(), nullptr };
+
+		size_t running = 0;
+		size_t spawned = 0;
+
+		// Feed a proc connector event to the controller.
+		auto inject = [&controller](unsigned int what, pid_t pid) {
+
+			char buffer[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(struct proc_event))];
+			memset(buffer,0,sizeof(buffer));
+
+			struct nlmsghdr *nlh = (struct nlmsghdr *) buffer;
+			nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(struct proc_event));
+			nlh->nlmsg_type = NLMSG_DONE;
+
+			struct cn_msg *cn_hdr = (struct cn_msg *) NLMSG_DATA(nlh);
+			cn_hdr->id.idx = CN_IDX_PROC;
+			cn_hdr->id.val = CN_VAL_PROC;
+			cn_hdr->len = sizeof(struct proc_event);
+
+			struct proc_event *ev = (struct proc_event *) cn_hdr->data;
+			ev->what = (decltype(ev->what)) what;
+			ev->event_data.exec.process_pid = pid;
+			ev->event_data.exec.process_tgid = pid;
+
+			controller.parse(buffer,nlh->nlmsg_len);
+
+		};
+
+		auto pump = [&controller,&running,&inject,injected](int timeout) {
+
+			if(!injected) {
+				struct pollfd pfd;
+				pfd.fd = controller.fd;
+				pfd.events = POLLIN;
+				while(poll(&pfd,1,timeout) > 0) {
+					controller.handle_event(MainLoop::Handler::oninput);
+					timeout = 0;
+				}
+			} else if(timeout) {
+				usleep(timeout * 1000);
+			}
+
+			pid_t pid;
+			int status;
+			while( (pid = waitpid(-1,&status,WNOHANG)) > 0) {
+				running--;
+				if(injected) {
+					inject(proc_event::PROC_EVENT_EXIT,pid);
+				}
+			}
+
+		};
+
+		auto begin = chrono::steady_clock::now();
+
+		for(unsigned int burst = 0; burst < bursts; burst++) {
+
+			for(unsigned int ix = 0; ix < children; ix++) {
+
+				pid_t pid;
+				if(posix_spawn(&pid,child,nullptr,nullptr,argv,environ)) {
+					throw runtime_error("Can't spawn child process");
+				}
+
+				// posix_spawn returns after the exec.
+				{
+					lock_guard<Controller::Guard> lock(Controller::guard);
+					probe.pending[pid] = chrono::steady_clock::now();
+				}
+
+				running++;
+				spawned++;
+
+				if(injected) {
+					inject(proc_event::PROC_EVENT_EXEC,pid);
+				} else {
+					pump(0);
+				}
+
+			}
+
+			pump(1);
+
+		}
+
+		// Drain.
+		while(running) {
+			pump(10);
+		}
+		pump((int) (100 + window));
+
+		// Wait for the event dispatcher.
+		for(;;) {
+			{
+				lock_guard<mutex> lock(controller.events.guard);
+				if(!controller.events.scheduled) {
+					break;
+				}
+			}
+			usleep(1000);
+		}
+		controller.expire();
+
+		double elapsed = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+		controller.remove(&probe);
+
+		auto &latencies = probe.latencies;
+		sort(latencies.begin(),latencies.end());
+
+		auto percentile = [&latencies](double p) {
+			if(latencies.empty()) {
+				return 0.0;
+			}
+			size_t index = (size_t) (p * latencies.size());
+			return latencies[min(index,latencies.size()-1)];
+		};
+
+		size_t lost = probe.pending.size();
+
+		printf(
+			"\nstorm: %zu children in %u bursts, %s events, %lu ms grace window\n",
+			spawned,
+			bursts,
+			(injected ? "injected" : "netlink"),
+			window
+		);
+		printf("%-12s %12s %12s %12s %12s\n","latency(us)","p50","p99","p999","max");
+		printf(
+			"%-12s %12.1f %12.1f %12.1f %12.1f\n",
+			"exec-bind",
+			percentile(0.50),
+			percentile(0.99),
+			percentile(0.999),
+			(latencies.empty() ? 0.0 : latencies.back())
+		);
+		printf("%-12s %12zu %12.1f/s\n","lost",lost,lost/elapsed);
+		printf("%-12s %12llu\n","coalesced",Controller::metrics.coalesced.load() - coalesced);
+		printf("%-12s %12llu\n","merged",Controller::metrics.merged.load() - merged);
+		printf("%-12s %12llu\n","overloads",Controller::metrics.overloads.load() - overloads);
+		printf(
+			"%-12s %12zu %12zu %12zu\n\n",
+			"pool",
+			controller.pool.counters.used.load(),
+			controller.pool.counters.high.load(),
+			controller.pool.counters.capacity.load()
+		);
+		fflush(stdout);
+
+	}
+
+ }
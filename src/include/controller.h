@@ -22,46 +22,439 @@
  #include <udjat/defs.h>
  #include <udjat/process/agent.h>
  #include <udjat/process/identifier.h>
+ #include <udjat/process/shared.h>
+ #include <udjat/process/subscriber.h>
+ #include <matcher.h>
+ #include <pool.h>
+ #include <recorder.h>
  #include <udjat/tools/handler.h>
  #include <udjat/tools/timer.h>
  #include <mutex>
  #include <list>
+ #include <vector>
+ #include <atomic>
+ #include <thread>
+ #include <chrono>
+ #include <deque>
+ #include <memory>
+ #include <unordered_set>
+ #include <unordered_map>
 
  namespace Udjat {
 
 	namespace Process {
 
+		class Benchmark;
+
 		class Controller : private MainLoop::Handler, private MainLoop::Timer {
+		public:
+
+			/// @brief Recursive mutex recording the wait and hold times of the outermost lock.
+			class Guard {
+			private:
+				std::recursive_mutex mutex;
+
+				/// @brief Lock depth on the current thread.
+				static thread_local unsigned int depth;
+
+				/// @brief When the current thread got the outermost lock.
+				static thread_local std::chrono::steady_clock::time_point acquired;
+
+			public:
+				void lock();
+				void unlock();
+
+			};
+
+			/// @brief Netlink event types.
+			enum EventType : uint8_t {
+				Exec,
+				Exit,
+				Ptrace,
+				Coredump,
+				Other
+			};
+
+			static constexpr size_t EventTypeCount = 5;
+
+			static const char * eventTypeNames[];
+
+			/// @brief Internal counters, updated with relaxed atomics.
+			struct Metrics {
+
+				/// @brief Refresh cycles.
+				std::atomic<unsigned long> refreshes{0};
+
+				/// @brief Duration of the last refresh in microseconds.
+				std::atomic<unsigned long> duration{0};
+
+				/// @brief procfs files read.
+				std::atomic<unsigned long long> files{0};
+
+				/// @brief procfs files read on the last refresh.
+				std::atomic<unsigned long> cycle{0};
+
+				/// @brief Netlink events, by type.
+				std::atomic<unsigned long long> events[EventTypeCount];
+
+				/// @brief Processes finished inside the grace window, never inserted.
+				std::atomic<unsigned long long> coalesced{0};
+
+				/// @brief Events merged with a queued event for the same pid.
+				std::atomic<unsigned long long> merged{0};
+
+				/// @brief Event queue overflows, handled with a reload.
+				std::atomic<unsigned long long> overloads{0};
+
+				/// @brief Controller::guard usage.
+				struct {
+					std::atomic<unsigned long long> count{0};	///< @brief Outermost locks.
+					std::atomic<unsigned long long> wait{0};	///< @brief Time waiting for the lock, in nanoseconds.
+					std::atomic<unsigned long long> hold{0};	///< @brief Time holding the lock, in nanoseconds.
+				} lock;
+
+				Metrics();
+
+				/// @brief Count a procfs file read.
+				inline void read() noexcept {
+					files.fetch_add(1,std::memory_order_relaxed);
+				}
+
+			};
+
+			static Metrics metrics;
+
+			/// @brief Identifier list, with nodes from the identifier pool.
+			typedef std::list<Identifier,Pool::Allocator<Identifier>> Identifiers;
+
 		private:
-			static std::recursive_mutex guard;
+			friend class Benchmark;
+			friend class Subscriber;
+
+			static Guard guard;
 
 			Controller();
 
 			struct {
 				/// @brief Update process CPU use.
 				bool cpu_use_per_process = true;
+
+				/// @brief Minimum CPU change, in %, to notify agents.
+				float cpu_delta = 1;
+
+				/// @brief Minimum RSS change, in bytes, to notify agents.
+				unsigned long long rss_delta = 1048576;
 			} update;
 
+			/// @brief Agents to notify on the next batch.
+			std::vector<Agent *> pending;
+
+			/// @brief Is there a notification task enqueued or running?
+			bool notifying = false;
+
+			/// @brief Agents on the running notification task, storage swapped with pending.
+			std::vector<Agent *> batch;
+
+			/// @brief Agent on updated(), called without the lock; removal waits for it.
+			std::atomic<Agent *> current{nullptr};
+
+			/// @brief Thread running the notification task.
+			std::thread::id notifier;
+
+			/// @brief Enqueue agent notification.
+			inline void notify(Agent *agent) {
+				pending.push_back(agent);
+			}
+
+			/// @brief Enqueue a task to notify pending agents.
+			void flush();
+
+			/// @brief EXEC events waiting for the grace window.
+			struct Deferred : public MainLoop::Timer {
+
+				Controller &controller;
+
+				/// @brief Grace window in milliseconds, 0 to insert on EXEC.
+				unsigned long window = 0;
+
+				/// @brief Waiting pids and their deadlines, in arrival order.
+				std::deque<std::pair<pid_t,std::chrono::steady_clock::time_point>> queue;
+
+				/// @brief Waiting pids, an EXIT removes the pid from here.
+				std::unordered_set<pid_t> waiting;
+
+				Deferred(Controller &c) : controller(c) {
+				}
+
+				void on_timer() override;
+
+			} deferred{*this};
+
+			/// @brief Proc connector events waiting for dispatch, coalesced by pid.
+			struct {
+
+				/// @brief Serializes the queue, never held with Controller::guard.
+				std::mutex guard;
+
+				/// @brief Queued pids, in arrival order.
+				std::vector<pid_t> order;
+
+				/// @brief Last event for each queued pid.
+				std::unordered_map<pid_t,EventType> last;
+
+				/// @brief Queue high-water mark, above it the events are replaced by a reload.
+				size_t limit = 4096;
+
+				/// @brief Queue overflowed, events are discarded until the reload.
+				bool overload = false;
+
+				/// @brief Is there a dispatch task enqueued?
+				bool scheduled = false;
+
+				/// @brief Events are queued but not dispatched until the initial population ends.
+				bool hold = false;
+
+				/// @brief Storage for the dispatch task, swapped with the queue.
+				struct {
+					std::vector<pid_t> order;
+					std::unordered_map<pid_t,EventType> last;
+				} work;
+
+			} events;
+
+			/// @brief Queue event, merging it with the queued event for the same pid.
+			void enqueue(const EventType type, const pid_t pid);
+
+			/// @brief Process queued events.
+			void dispatch();
+
+			/// @brief Queue new process for the grace window.
+			/// @brief Tracked processes (a new image on the same pid) are probed again at once.
+			void defer(const pid_t pid);
+
+			/// @brief Cancel a waiting process.
+			/// @return true if the process was waiting.
+			bool cancel(const pid_t pid);
+
+			/// @brief Insert the processes whose grace window expired, if still alive.
+			void expire();
+
 			/// @brief Get pid list.
-			static void load(std::list<pid_t> &pids);
+			/// @param pids The pids from procfs, sorted (storage is reused).
+			static void load(std::vector<pid_t> &pids);
 
 			/// @brief Update process list.
-			void reload() noexcept;
+			/// @param reprobe Probe the agents again for the processes whose executable changed (lost EXEC events).
+			void reload(bool reprobe = false) noexcept;
+
+			/// @brief Initial population state.
+			struct {
+
+				/// @brief Population tasks still running.
+				std::atomic<size_t> tasks{0};
+
+				/// @brief Pids inserted by other paths while populating (protected by guard).
+				std::unordered_set<pid_t> inserted;
+
+			} startup;
+
+			/// @brief Load the initial process list on the ThreadPool.
+			/// @param threads Number of parallel tasks (0 for the number of cores).
+			void populate(size_t threads);
+
+			/// @brief Insert and probe a range of the initial pids.
+			void populate(const std::vector<pid_t> &pids, size_t from, size_t to) noexcept;
+
+			/// @brief Initial population finished, release the queued events.
+			void populated() noexcept;
 
 			void handle_event(const Event event) override;
+
+			/// @brief Process proc connector messages.
+			/// @param buffer The netlink messages.
+			/// @param length The buffer length.
+			void parse(const void *buffer, ssize_t length);
 			void on_timer() override;
 
+			/// @brief Storage for the identifiers, recycled on process churn.
+			Pool pool;
+
 			/// @brief Process identifiers.
-			std::list<Identifier> identifiers;
+			Identifiers identifiers{Pool::Allocator<Identifier>(pool)};
+
+			/// @brief Refresh values, in parallel arrays indexed by Identifier::slot.
+			struct Slots {
+
+				std::vector<Identifier *> owner;			///< @brief Identifier on the slot, nullptr if free.
+				std::vector<pid_t> pid;						///< @brief Process id.
+				std::vector<unsigned long> ticks;			///< @brief utime+stime on the last refresh.
+				std::vector<float> delta;					///< @brief Ticks used on the last refresh interval.
+				std::vector<float> percent;					///< @brief CPU usage on the last refresh interval (0 to 1).
+				std::vector<Identifier::State> state;		///< @brief Process state on the last refresh.
+				std::vector<Identifiers::iterator> entry;	///< @brief Position on the identifier list.
+
+				/// @brief Free slots.
+				std::vector<uint32_t> available;
+
+				/// @brief Slot by pid, for the event and lookup paths.
+				std::unordered_map<pid_t,uint32_t> index;
+
+				/// @brief Get a slot for identifier.
+				/// @param entry The identifier on the list.
+				uint32_t allocate(Identifiers::iterator entry);
+
+				/// @brief Return slot to the free list.
+				void release(uint32_t slot) noexcept;
+
+				/// @brief Get the identifier tracking pid.
+				/// @return The identifier, nullptr if the pid is not tracked.
+				Identifier * find(pid_t pid) const noexcept;
+
+				void clear() noexcept;
+
+				inline size_t size() const noexcept {
+					return owner.size();
+				}
+
+			} slots;
+
+			/// @brief Per-process metrics exported in shared memory.
+			struct {
+				std::string path;					///< @brief The exported file, empty if disabled.
+				Shared::Header *header = nullptr;	///< @brief The mapped file.
+				size_t length = 0;					///< @brief The mapping length.
+			} shared;
+
+			/// @brief Create and map the shared memory export.
+			/// @param path The file path (usually on /dev/shm).
+			/// @param capacity Maximum number of exported processes.
+			void share(const char *path, uint32_t capacity);
+
+			/// @brief Remove the shared memory export.
+			void unshare() noexcept;
+
+			/// @brief Write the refresh values to the shared memory export.
+			/// @param cpu The system CPU usage (0 to 1).
+			void publish(float cpu) noexcept;
+
+			/// @brief Processes with agents on the current refresh, and the values before it.
+			struct Bound {
+				Identifier *info;
+				float cpu;
+				unsigned long long rss;
+				bool state;		///< @brief Did the state change?
+			};
+
+			/// @brief Work storage for refresh, kept between cycles.
+			struct {
+				std::vector<Bound> bound;
+				std::vector<pid_t> stale;
+				std::unordered_map<pid_t,Identifier *> index;
+			} work;
+
+			/// @brief Refresh recorder, see [process] recorder.
+			std::unique_ptr<Recording::Writer> recorder;
+
+			/// @brief Recorder serialization and snapshot, written without the controller lock.
+			struct {
+				std::mutex guard;
+				std::vector<Recording::Writer::Entry> entries;
+			} recording;
+
+			/// @brief Recording replayed instead of the system, see [process] replay.
+			struct {
+				std::unique_ptr<Recording::Reader> reader;
+				Recording::Generation generation;
+			} player;
+
+			/// @brief Append the refresh values to the recorder.
+			/// Locks the controller only to copy the values, call without holding it.
+			void record() noexcept;
+
+			/// @brief Apply a recorded generation, as a refresh would.
+			void replay(const Recording::Generation &generation);
+
+			/// @brief Replay the next generation from the player.
+			/// @return false when the recording ends.
+			bool play() noexcept;
+
+			/// @brief Add identifier.
+			Identifier & emplace(pid_t pid);
+
+			/// @brief Add identifier with known start time.
+			Identifier & emplace(pid_t pid, unsigned long long starttime);
+
+			/// @brief Remove all identifiers.
+			void clear() noexcept;
 
 			/// @brief Active agents.
 			std::list<Agent *> agents;
 
+			/// @brief Compiled patterns from active agents.
+			Matcher matcher;
+
+			/// @brief Agents without patterns, probed for every new process.
+			std::list<Agent *> unindexed;
+
 			/// @brief Update CPU usage.
 			void refresh() noexcept;
 
+			/// @brief Read the process values from procfs, the locked part of refresh().
+			void scan() noexcept;
+
+			/// @brief Compute CPU usage by slot and notify the bound agents.
+			/// @param sysusage The system CPU usage (0 to 1).
+			/// @param totaltime Ticks used by all processes in the interval.
+			void evaluate(float sysusage, float totaltime) noexcept;
+
+			/// @brief Notify the agents of the bound processes whose values changed on the refresh.
+			void report() noexcept;
+
+			/// @brief Update agent histories and timed states, flush notifications.
+			void sample() noexcept;
+
 			void onInsert(Identifier &identifier);
 
+			/// @brief Probe agents for a new identifier.
+			/// @param subject The process properties, possibly preloaded.
+			void onInsert(Identifier &identifier, Matcher::Subject &subject);
+
+			/// @brief State transition filter.
+			struct Subscription {
+				Subscriber *subscriber;
+				Identifier::State from;		///< @brief Undefined for any.
+				Identifier::State to;		///< @brief Undefined for any.
+			};
+
+			/// @brief Transition subscriptions.
+			struct {
+
+				/// @brief State transition filters.
+				std::vector<Subscription> transitions;
+
+				/// @brief All subscribers, for bind and unbind.
+				std::vector<Subscriber *> subscribers;
+
+			} subscriptions;
+
+			/// @brief Notify subscribers of a state transition.
+			/// @param from The previous state (Unknown or Undefined for a new process).
+			/// @param to The new state (Undefined for a removed process).
+			void transition(const Identifier &identifier, Identifier::State from, Identifier::State to) noexcept;
+
+			/// @brief Deliver a kernel signal to the agents bound to the process.
+			/// @param type The event type (Coredump or Ptrace).
+			/// @param pid The process id.
+			/// @param tracer The tracer pid on Ptrace, 0 on detach.
+			void signal(const EventType type, const pid_t pid, const pid_t tracer = 0) noexcept;
+
+			/// @brief Bind agent to identifier.
+			/// @return true if the agent accepted the identifier.
+			bool bind(Agent *agent, Identifier &identifier);
+
+			/// @brief Unbind agent from identifier.
+			void unbind(Agent *agent, Identifier &identifier);
+
 			void insert(const pid_t pid) noexcept;
 			void remove(const pid_t pid) noexcept;
 
@@ -82,12 +475,50 @@
 
 			size_t count(const Process::Identifier::State state);
 
+			/// @brief Count processes on state and subscribe to its transitions.
+			/// @param state The process state.
+			/// @param subscriber Notified of the transitions from and to state.
+			/// @return The number of processes on state on the last refresh.
+			size_t count(const Process::Identifier::State state, Subscriber *subscriber);
+
 			inline float getSystemCpuUse() const noexcept {
 				return system.cpu;
 			}
 
+			/// @brief Get the number of tracked identifiers.
+			size_t size();
+
+			/// @brief Get the identifier storage.
+			inline const Pool & getPool() const noexcept {
+				return pool;
+			}
+
 			Identifier * find(const pid_t pid);
 
+			/// @brief Process resource consumption.
+			struct Consumer {
+				pid_t pid = -1;
+				unsigned long long starttime = 0;
+				double value = 0;		///< @brief Exact for byte and tick counts (below 2^53).
+			};
+
+			/// @brief Get the heaviest processes from the last refresh.
+			/// @param consumers Preallocated storage, filled with up to count entries, heaviest first.
+			/// @param count Number of processes to select.
+			/// @param value Get the resource consumption of a process.
+			void top(std::vector<Consumer> &consumers, size_t count, double (*value)(const Identifier &ident));
+
+			/// @brief Get the process table from the last refresh.
+			/// @param request The request; arguments 'state', 'exename' (pattern), 'uid' filter
+			///                the processes, 'sort' (pid, cpu or rss), 'offset' and 'limit' select the page.
+			/// @param response The table.
+			void get(const Request &request, Response &response);
+
+			/// @brief Bind agent to a single identifier, replacing the current one.
+			/// @param agent The agent.
+			/// @param identifier The new identifier (nullptr to unbind).
+			void set(Agent *agent, Identifier *identifier);
+
 		};
 
 	}
@@ -0,0 +1,204 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ #pragma once
+
+ #include <udjat/defs.h>
+ #include <udjat/process/agent.h>
+ #include <udjat/process/identifier.h>
+ #include <string>
+ #include <vector>
+ #include <unordered_map>
+
+ namespace Udjat {
+
+	namespace Process {
+
+		/// @brief Compiled matcher for the patterns of all agents.
+		///
+		/// Every agent pattern is reduced to its longest literal and all the
+		/// literals are compiled in a single Aho-Corasick automaton; a new
+		/// process is scanned once per field and only the patterns whose
+		/// literal was found are verified with fnmatch(3). Patterns without
+		/// wildcards are resolved by a hash lookup.
+		class Matcher {
+		public:
+
+			/// @brief Process properties used for matching.
+			enum Field : uint8_t {
+				ExeName,	///< @brief Executable path, from /proc/pid/exe (case insensitive).
+				CmdLine,	///< @brief Command line, from /proc/pid/cmdline, arguments separated by spaces.
+				Comm,		///< @brief Command name, from /proc/pid/comm.
+			};
+
+			static constexpr size_t FieldCount = 3;
+
+			static const char * fieldNames[];
+
+			/// @brief Process properties, loaded on demand.
+			class Subject {
+			private:
+				const Identifier &identifier;
+				bool loaded[FieldCount] = { false, false, false };
+				std::string values[FieldCount];
+
+			public:
+				Subject(const Identifier &i) : identifier(i) {
+				}
+
+				const std::string & operator[](const Field field);
+
+				/// @brief Set a value loaded elsewhere (outside the controller lock).
+				void set(const Field field, std::string &&value) noexcept;
+
+				/// @brief Release a cached value.
+				void release(const Field field) noexcept;
+
+			};
+
+			/// @brief Test a single pattern against a process.
+			static bool test(Subject &subject, const Field field, const char *pattern);
+
+			/// @brief Register an agent pattern.
+			/// @param agent The agent to report when the pattern matches.
+			/// @param field The process property to test.
+			/// @param pattern The pattern (shell wildcard, see fnmatch(3)).
+			/// @param exename If not null the pattern is tested only for processes with this exename.
+			void insert(Agent *agent, const Field field, const char *pattern, const char *exename = nullptr);
+
+			/// @brief Remove all patterns from agent.
+			void remove(const Agent *agent);
+
+			/// @brief Get agents matching the process.
+			/// @param subject The process properties.
+			/// @param agents List of matching agents (appended).
+			void probe(Subject &subject, std::vector<Agent *> &agents);
+
+			inline bool empty() const noexcept {
+				return patterns.empty();
+			}
+
+		private:
+
+			/// @brief Aho-Corasick automaton.
+			class Automaton {
+			private:
+
+				struct Node {
+					/// @brief Goto function, sorted by character.
+					std::vector<std::pair<unsigned char,uint32_t>> next;
+					uint32_t fail = 0;			///< @brief Failure link.
+					uint32_t output = 0;		///< @brief Nearest node (self or in the failure chain) with ids, 0 if none.
+					std::vector<uint32_t> ids;	///< @brief Pattern ids ending on this node.
+				};
+
+				std::vector<Node> nodes;
+
+				uint32_t child(uint32_t node, unsigned char chr) const noexcept;
+
+			public:
+				Automaton();
+
+				void clear();
+
+				inline bool empty() const noexcept {
+					return nodes.size() == 1;
+				}
+
+				/// @brief Add a lowercase literal.
+				void insert(const std::string &literal, uint32_t id);
+
+				/// @brief Build failure and output links.
+				void compile();
+
+				/// @brief Scan text (case insensitive).
+				/// @param text The text to scan.
+				/// @param call Called with the pattern id for every literal found (may repeat).
+				template <typename T>
+				void search(const std::string &text, T call) const {
+					uint32_t state = 0;
+					for(unsigned char chr : text) {
+						chr = (unsigned char) tolower(chr);
+						uint32_t next;
+						while( !(next = child(state,chr)) && state) {
+							state = nodes[state].fail;
+						}
+						state = next;
+						for(uint32_t out = nodes[state].output; out; out = nodes[nodes[out].fail].output) {
+							for(auto id : nodes[out].ids) {
+								call(id);
+							}
+						}
+					}
+				}
+
+			};
+
+			struct Pattern {
+				Agent *agent;
+				Field field;
+				std::string pattern;
+				std::string exename;	///< @brief Required exename (lowercase), empty for none.
+
+				Pattern(Agent *a, Field f, const char *p, const char *e);
+			};
+
+			/// @brief Registered patterns.
+			std::vector<Pattern> patterns;
+
+			/// @brief Compiled patterns, by field.
+			struct {
+				Automaton automaton;
+
+				/// @brief Patterns without wildcards.
+				std::unordered_multimap<std::string,uint32_t> exact;
+
+				/// @brief Patterns without literals, tested for every process.
+				std::vector<uint32_t> always;
+
+				inline bool empty() const noexcept {
+					return automaton.empty() && exact.empty() && always.empty();
+				}
+
+			} compiled[FieldCount];
+
+			/// @brief Patterns with an exename prefilter, by exename (lowercase).
+			std::unordered_multimap<std::string,uint32_t> filtered;
+
+			/// @brief Need to rebuild the compiled patterns?
+			bool dirty = false;
+
+			/// @brief Candidate marks, indexed by pattern id.
+			std::vector<uint32_t> marks;
+			uint32_t generation = 0;
+
+			void compile();
+
+			/// @brief Get the longest literal of a wildcard pattern.
+			/// @param pattern The pattern.
+			/// @param literal The longest literal, lowercase.
+			/// @return true if the pattern has wildcards.
+			static bool literal(const char *pattern, std::string &literal);
+
+		};
+
+	}
+
+ }
+
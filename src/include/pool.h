@@ -0,0 +1,116 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ #pragma once
+
+ #include <udjat/defs.h>
+ #include <atomic>
+ #include <memory>
+ #include <vector>
+
+ namespace Udjat {
+
+	/// @brief Free list of fixed size blocks.
+	///
+	/// Blocks are allocated in slabs and recycled, never returned to the
+	/// heap; after a burst the memory stays at the high-water mark. Not
+	/// thread safe, the owner must serialize the allocations.
+	class Pool {
+	private:
+
+		/// @brief Block size, set on the first allocation.
+		size_t size = 0;
+
+		/// @brief Blocks per slab.
+		size_t blocks;
+
+		std::vector<std::unique_ptr<char[]>> slabs;
+
+		/// @brief First free block.
+		void *available = nullptr;
+
+		/// @brief Allocate a new slab and add its blocks to the free list.
+		void grow();
+
+	public:
+
+		/// @brief Allocation counters, readable from any thread.
+		struct {
+			std::atomic<size_t> used{0};		///< @brief Blocks in use.
+			std::atomic<size_t> high{0};		///< @brief Maximum blocks in use.
+			std::atomic<size_t> capacity{0};	///< @brief Blocks allocated.
+		} counters;
+
+		/// @param blocks Number of blocks per slab.
+		Pool(size_t blocks = 1024) : blocks(blocks) {
+		}
+
+		Pool(const Pool &) = delete;
+
+		void * allocate(size_t size);
+		void deallocate(void *ptr, size_t size) noexcept;
+
+		/// @brief STL allocator on a pool, for node based containers.
+		template <typename T>
+		class Allocator {
+		private:
+			template <typename U> friend class Allocator;
+			Pool *pool;
+
+		public:
+			typedef T value_type;
+
+			Allocator(Pool &p) noexcept : pool(&p) {
+			}
+
+			template <typename U>
+			Allocator(const Allocator<U> &other) noexcept : pool(other.pool) {
+			}
+
+			T * allocate(size_t n) {
+				if(n != 1) {
+					return std::allocator<T>().allocate(n);
+				}
+				return static_cast<T *>(pool->allocate(sizeof(T)));
+			}
+
+			void deallocate(T *ptr, size_t n) noexcept {
+				if(n != 1) {
+					std::allocator<T>().deallocate(ptr,n);
+					return;
+				}
+				pool->deallocate(ptr,sizeof(T));
+			}
+
+			template <typename U>
+			bool operator==(const Allocator<U> &other) const noexcept {
+				return pool == other.pool;
+			}
+
+			template <typename U>
+			bool operator!=(const Allocator<U> &other) const noexcept {
+				return pool != other.pool;
+			}
+
+		};
+
+	};
+
+ }
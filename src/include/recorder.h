@@ -0,0 +1,227 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ #pragma once
+
+ #include <udjat/defs.h>
+ #include <udjat/process/identifier.h>
+ #include <matcher.h>
+ #include <cstdint>
+ #include <mutex>
+ #include <string>
+ #include <vector>
+ #include <unordered_map>
+
+ namespace Udjat {
+
+	namespace Process {
+
+		/// @brief Refresh generations stored in a fixed size ring file.
+		///
+		/// The file is a Header followed by the ring. Each frame is a 32 bit
+		/// length, a flags byte and the payload; a zero length marks the end of
+		/// the used ring before it wraps. The payload is columnar: the removed
+		/// pids, the spawned processes (pid, start time and matcher fields) and
+		/// the changed processes (pid, state, ticks, rss and vsize pages). Pids are
+		/// sorted and delta encoded, ticks and pages are varints relative to the previous
+		/// generation. Key frames are relative to an empty table, replay starts
+		/// on the first key frame in the ring.
+		namespace Recording {
+
+			static constexpr uint32_t Magic = 0x52525055;	///< @brief "UPRR".
+			static constexpr uint32_t Version = 2;
+
+			struct Header {
+				uint32_t magic;
+				uint32_t version;
+				uint64_t size;			///< @brief Ring length in bytes.
+				uint64_t head;			///< @brief Offset of the oldest frame.
+				uint64_t tail;			///< @brief Offset for the next frame.
+				uint64_t frames;		///< @brief Number of frames in the ring.
+				uint32_t pagesize;		///< @brief Page size for the rss values.
+				uint32_t reserved[5];
+			};
+
+			static_assert(sizeof(Header) == 64, "Unexpected recording header size");
+
+			/// @brief Frame flags.
+			enum Flags : uint8_t {
+				Key = 1		///< @brief Frame is relative to an empty table.
+			};
+
+			/// @brief Process values on a generation.
+			struct Sample {
+				pid_t pid;
+				Identifier::State state;
+				unsigned long ticks;		///< @brief utime+stime.
+				unsigned long long rss;		///< @brief Resident set size in bytes.
+				unsigned long long vsize;	///< @brief Virtual memory size in bytes.
+			};
+
+			/// @brief New process.
+			struct Spawn {
+				pid_t pid;
+				unsigned long long starttime;
+				std::string values[Matcher::FieldCount];	///< @brief Matcher fields, by Matcher::Field.
+			};
+
+			/// @brief Decoded generation.
+			struct Generation {
+
+				bool key = false;
+				uint64_t number = 0;				///< @brief Refresh counter.
+				uint64_t timestamp = 0;				///< @brief Milliseconds since the epoch.
+				unsigned long long running = 0;		///< @brief System running ticks.
+				unsigned long long idle = 0;		///< @brief System idle ticks.
+
+				std::vector<pid_t> removed;
+				std::vector<Spawn> spawned;
+				std::vector<Sample> changed;		///< @brief Absolute values of the spawned and changed processes.
+
+				void clear() noexcept;
+
+			};
+
+			/// @brief Appends generations to a ring file.
+			class Writer {
+			public:
+
+				/// @brief A process on the current generation.
+				struct Entry {
+					Sample sample;
+					unsigned long long starttime;
+					std::string exename;		///< @brief Set for the processes not known() by the writer.
+				};
+
+			private:
+
+				int fd = -1;
+				Header header;
+
+				/// @brief Generations since the last key frame.
+				unsigned int since = 0;
+
+				/// @brief Generations between key frames.
+				unsigned int keyframe;
+
+				/// @brief Values on the last generation, by pid.
+				struct Last {
+					unsigned long long starttime;
+					Identifier::State state;
+					unsigned long ticks;
+					uint64_t pages;
+					uint64_t vpages;
+					uint64_t epoch;
+					std::string values[Matcher::FieldCount];	///< @brief Matcher fields, kept for the key frames.
+				};
+
+				std::unordered_map<pid_t,Last> last;
+				uint64_t epoch = 0;
+
+				/// @brief Pids exited since the last generation, see exited().
+				struct {
+					std::mutex guard;
+					std::vector<pid_t> pids;
+				} exits;
+
+				/// @brief Work storage, kept between generations.
+				struct {
+					std::vector<uint8_t> frame;
+					std::vector<pid_t> exited;
+					std::vector<pid_t> removed;
+					std::vector<const Entry *> spawned;
+					std::vector<const Entry *> changed;
+				} work;
+
+				/// @brief Drop the oldest frame.
+				void evict();
+
+				/// @brief Store frame on the ring.
+				void append();
+
+			public:
+				/// @brief Open or create a recording.
+				/// @param path The file path; a recording with the same size is continued.
+				/// @param size The ring length in bytes.
+				/// @param keyframe Generations between key frames.
+				Writer(const char *path, uint64_t size, unsigned int keyframe);
+				~Writer();
+
+				/// @brief Check if the process is on the last generation.
+				/// @return true if the entry for the process doesn't need the exename.
+				bool known(pid_t pid, unsigned long long starttime) const noexcept;
+
+				/// @brief Forget an exited process, it's removed on the next generation.
+				/// @param pid The process id, doesn't wait for a write in progress.
+				void exited(pid_t pid);
+
+				/// @brief Append generation.
+				/// @param entries All processes (sorted by pid on return).
+				/// The command line and name of the new processes are read from procfs.
+				void write(uint64_t number, unsigned long long running, unsigned long long idle, std::vector<Entry> &entries);
+
+			};
+
+			/// @brief Reads the generations from a ring file, oldest first.
+			class Reader {
+			private:
+
+				int fd = -1;
+				Header header;
+
+				/// @brief Frames not read.
+				uint64_t remaining;
+
+				/// @brief Offset of the next frame.
+				uint64_t offset;
+
+				/// @brief Found the first key frame?
+				bool synced = false;
+
+				/// @brief Values on the last generation, by pid.
+				struct Last {
+					unsigned long ticks = 0;
+					uint64_t pages = 0;
+					uint64_t vpages = 0;
+				};
+
+				std::unordered_map<pid_t,Last> last;
+
+				std::vector<uint8_t> frame;
+
+				/// @brief Read the next frame.
+				/// @return false if there are no more frames.
+				bool load();
+
+			public:
+				Reader(const char *path);
+				~Reader();
+
+				/// @brief Decode the next generation.
+				/// @return false if there are no more generations.
+				bool read(Generation &generation);
+
+			};
+
+		}
+
+	}
+
+ }
@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ /**
+  * @brief USDT static tracepoints (provider "udjat_process").
+  *
+  * Enabled with ./configure --enable-usdt, expand to nothing otherwise; the
+ * arguments are evaluated only when probes are enabled.
+  *
+  * refresh_start(identifiers)		Refresh cycle begins.
+  * refresh_end(us, identifiers)	Refresh cycle ends, with its duration in microseconds.
+  * event(what, pid)				Proc connector event received (PROC_EVENT_* value).
+  * insert(pid, ns)				Identifier inserted and probed, with the probe duration in nanoseconds.
+  * remove(pid)					Identifier removed.
+  * bind(pid, agent)				Agent bound to the process (agent name).
+  * unbind(pid, agent)				Agent unbound from the process (agent name).
+  * state(pid, from, to)			Process state changed (state characters).
+  *
+  */
+
+ #pragma once
+
+ #include <config.h>
+ #include <cstdint>
+
+ #ifdef HAVE_USDT
+
+	#include <sys/sdt.h>
+	#include <time.h>
+
+	#define PROCESS_PROBE1(name,a)			DTRACE_PROBE1(udjat_process,name,a)
+	#define PROCESS_PROBE2(name,a,b)		DTRACE_PROBE2(udjat_process,name,a,b)
+	#define PROCESS_PROBE3(name,a,b,c)		DTRACE_PROBE3(udjat_process,name,a,b,c)
+
+	/// @brief Get timestamp for probe durations.
+	/// @return Monotonic time in nanoseconds.
+	static inline uint64_t probe_clock() noexcept {
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC,&ts);
+		return ((uint64_t) ts.tv_sec) * 1000000000 + ts.tv_nsec;
+	}
+
+ #else
+
+	// Arguments are not evaluated, probes must not carry side effects.
+	#define PROCESS_PROBE1(name,a)			do {} while(0)
+	#define PROCESS_PROBE2(name,a,b)		do {} while(0)
+	#define PROCESS_PROBE3(name,a,b,c)		do {} while(0)
+
+	static constexpr uint64_t probe_clock() noexcept {
+		return 0;
+	}
+
+ #endif // HAVE_USDT
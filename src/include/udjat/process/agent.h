@@ -23,6 +23,8 @@
  #include <udjat/agent.h>
  #include <udjat/agent/state.h>
  #include <udjat/process/identifier.h>
+ #include <udjat/process/history.h>
+ #include <memory>
 
  namespace Udjat {
 
@@ -40,6 +42,22 @@
 			/// @brief Agent states.
 			std::vector<std::shared_ptr<State>> states;
 
+			/// @brief Has time dependent states? They need evaluation on every refresh.
+			bool timed = false;
+
+			/// @brief Sample history, nullptr if disabled.
+			std::unique_ptr<History> history;
+
+			/// @brief Add current values to history.
+			void sample();
+
+			/// @brief Kernel signals on the bound processes (protected by the controller lock).
+			struct {
+				unsigned int coredumps = 0;		///< @brief Coredumps since the agent start.
+				unsigned int ptraces = 0;		///< @brief Tracer attachments since the agent start.
+				bool crashed = false;			///< @brief Did a bound process dump core? Cleared on the next bind.
+			} signals;
+
 		protected:
 			Agent();
 			Agent(const pugi::xml_node &node);
@@ -60,6 +78,11 @@
 			/// @return true if the identifier match the agent requirements.
 			virtual bool probe(const Identifier &ident) const noexcept;
 
+			/// @brief Register the agent patterns on the process matcher.
+			/// @param matcher The controller matcher.
+			/// @return false if the agent has no patterns and should be probed for every new process.
+			virtual bool index(Matcher &matcher);
+
 			std::shared_ptr<Abstract::State> computeState() override;
 
 			/// @brief Set process pid.
@@ -68,6 +91,30 @@
 			/// @brief Set process identifier.
 			virtual void set(Identifier *info);
 
+			/// @brief Bind agent to a matching process.
+			/// @param ident The process identifier.
+			/// @return true if the identifier was accepted.
+			virtual bool bind(Identifier *ident);
+
+			/// @brief Process is no longer available.
+			/// @param ident The process identifier.
+			virtual void unbind(Identifier *ident);
+
+			/// @brief Bound process was refreshed.
+			/// @param ident The process identifier, with the updated values.
+			/// @param cpu The CPU usage before the refresh (in %).
+			/// @param rss The resident set size before the refresh.
+			virtual void changed(const Identifier &ident, float cpu, unsigned long long rss);
+
+			/// @brief Bound process is dumping core, the EXIT event follows.
+			/// @param ident The process identifier.
+			virtual void coredump(const Identifier &ident);
+
+			/// @brief A tracer attached to or detached from the bound process.
+			/// @param ident The process identifier.
+			/// @param tracer The tracer pid, 0 on detach.
+			virtual void ptrace(const Identifier &ident, pid_t tracer);
+
 		public:
 			static std::shared_ptr<Udjat::Abstract::Agent> AgentFactory(const pugi::xml_node &node);
 
@@ -79,12 +126,33 @@
 
 			std::shared_ptr<Abstract::State> StateFactory(const pugi::xml_node &node) override;
 
-			Process::Identifier::State getState() const noexcept;
+			/// @brief Get sample history.
+			/// @return The agent history, nullptr if disabled (history-length='0').
+			inline const History * getHistory() const noexcept {
+				return history.get();
+			}
+
+			virtual Process::Identifier::State getState() const noexcept;
+
+			virtual float getCPU() const noexcept;
+
+			/// @brief Did a bound process dump core since the last bind?
+			inline bool crashed() const noexcept {
+				return signals.crashed;
+			}
 
-			float getCPU() const noexcept;
+			/// @brief Coredumps on the bound processes since the agent start.
+			inline unsigned int getCoredumps() const noexcept {
+				return signals.coredumps;
+			}
+
+			/// @brief Tracer attachments on the bound processes since the agent start.
+			inline unsigned int getPtraces() const noexcept {
+				return signals.ptraces;
+			}
 
 			/// @brief The size of memory that are currently resident in RAM in bytes.
-			unsigned long long getRSS() const;
+			virtual unsigned long long getRSS() const;
 
 			/// @brief Virtual memory size in bytes.
 			unsigned long long getVSize() const;
@@ -103,11 +171,30 @@
 			static Field getField(const char *name);
 
 			/// @brief Get field value in bytes.
-			unsigned long long getValue(Field field) const;
+			virtual unsigned long long getValue(Field field) const;
 
 			/// @brief Get field value in % of the system total.
 			float getPercent(Field field) const;
 
+			/// @brief Response values, selected by the 'fields' request argument.
+			enum Selection : uint8_t {
+				SelectCPU		= 0x01,	///< @brief "cpu"
+				SelectRSS		= 0x02,	///< @brief "rss"
+				SelectVSize		= 0x04,	///< @brief "vsize"
+				SelectMode		= 0x08,	///< @brief "mode"
+				SelectHistory	= 0x10,	///< @brief "history"
+				SelectInstances	= 0x20,	///< @brief "instances"
+				SelectSignals	= 0x40,	///< @brief "signals"
+				SelectAll		= 0xff
+			};
+
+			static const char * selectionNames[];
+
+			/// @brief Get the response values requested.
+			/// @param request The request, with an optional comma separated list of names on the 'fields' argument.
+			/// @return The selected values (SelectAll if there's no selection).
+			static uint8_t getSelection(const Request &request);
+
  		};
 
  	}
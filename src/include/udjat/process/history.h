@@ -0,0 +1,155 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ #pragma once
+
+ #include <udjat/defs.h>
+ #include <mutex>
+ #include <vector>
+ #include <cstdint>
+
+ namespace Udjat {
+
+	namespace Process {
+
+		/// @brief Fixed size sample history with rolling statistics.
+		/// @brief All storage is allocated on construction.
+		class UDJAT_API History {
+		public:
+
+			/// @brief Sampled values.
+			enum Metric : uint8_t {
+				CPU,	///< @brief CPU usage in %.
+				RSS,	///< @brief Resident set size in bytes.
+				VSize,	///< @brief Virtual memory size in bytes.
+				IOWait	///< @brief Block I/O delay in clock ticks (needs delay accounting).
+			};
+
+			static constexpr size_t MetricCount = 4;
+
+			static const char * metricNames[];
+			static Metric MetricFactory(const char *name);
+
+			/// @brief Statistics from the samples in the window.
+			enum Statistic : uint8_t {
+				Last,		///< @brief Last sample.
+				Min,		///< @brief Minimum value.
+				Max,		///< @brief Maximum value.
+				Mean,		///< @brief Arithmetic mean.
+				EWMA,		///< @brief Exponentially weighted moving average.
+				Percentile	///< @brief Percentile, "p" followed by the percentile (p50, p95, p99).
+			};
+
+			static const char * statisticNames[];
+
+			/// @brief Get statistic from name.
+			/// @param name The statistic name.
+			/// @param percentile Set to the percentile, if the name is a percentile.
+			static Statistic StatisticFactory(const char *name, float &percentile);
+
+		private:
+
+			/// @brief Ring buffer for one metric.
+			class Series {
+			private:
+
+				/// @brief Samples, indexed by sequence % size.
+				std::vector<float> values;
+
+				/// @brief Number of samples pushed.
+				uint64_t sequence = 0;
+
+				double sum = 0;
+				float ewma = 0;
+
+				/// @brief Monotonic queue of sequence numbers, for sliding window min/max.
+				class Wedge {
+				private:
+					std::vector<uint64_t> items;
+					size_t first = 0;
+					size_t count = 0;
+
+				public:
+					void setup(size_t length);
+
+					/// @brief Push sample, dropping the ones it dominates.
+					/// @param better Test if the new value dominates an old one.
+					template <typename T>
+					void push(const std::vector<float> &values, uint64_t sequence, T better) {
+						float value = values[sequence % values.size()];
+						while(count && better(value,values[items[(first+count-1) % items.size()] % values.size()])) {
+							count--;
+						}
+						items[(first+count) % items.size()] = sequence;
+						count++;
+					}
+
+					/// @brief Remove samples older than sequence.
+					void expire(uint64_t sequence);
+
+					inline uint64_t front() const noexcept {
+						return items[first];
+					}
+
+				} minimum, maximum;
+
+				/// @brief Work buffer for percentiles.
+				mutable std::vector<float> scratch;
+
+				inline size_t size() const noexcept {
+					return sequence < values.size() ? (size_t) sequence : values.size();
+				}
+
+			public:
+				void setup(size_t length);
+				void push(float value, float alpha);
+				float get(Statistic statistic, float percentile) const;
+
+			} series[MetricCount];
+
+			mutable std::mutex guard;
+
+			/// @brief EWMA smoothing factor.
+			float alpha;
+
+		public:
+			/// @brief Build history.
+			/// @param length Number of samples in the window.
+			/// @param alpha EWMA smoothing factor (0 to 1).
+			History(size_t length, float alpha);
+
+			/// @brief Add samples.
+			/// @param values The current values, indexed by metric.
+			void push(const float values[MetricCount]);
+
+			/// @brief Get statistic.
+			/// @param metric The sampled value.
+			/// @param statistic The statistic.
+			/// @param percentile The percentile (0 to 100), for Statistic::Percentile.
+			/// @return The statistic value, 0 if there are no samples.
+			float get(const Metric metric, const Statistic statistic, float percentile = 0) const;
+
+			/// @brief Export statistics.
+			void get(Udjat::Value &value) const;
+
+		};
+
+	}
+
+ }
@@ -21,12 +21,18 @@
 
  #include <udjat/defs.h>
  #include <list>
+ #include <vector>
+ #include <string>
+ #include <ctime>
+ #include <sys/types.h>
 
  namespace Udjat {
 
  	namespace Process {
 
  		class Controller;
+ 		class Matcher;
+ 		class Agent;
 
  		/// @brief Process identifier.
 		/// @brief A single process.
@@ -48,7 +54,8 @@
 				Waking			= 'W',	///< @brief Waking (Linux 2.6.33 to 3.13 only).
 				Parked			= 'P',	///< @brief Parked (Linux 3.9 to 3.13 only).
 
-				Undefined		= 0		///< @brief Undefined.
+				Undefined		= 0,	///< @brief Undefined.
+				Unknown			= 0xff	///< @brief Not read yet (identifier not refreshed since inserted).
 			};
 
 			static const struct StateName {
@@ -65,6 +72,12 @@
 
 			pid_t pid = -1;
 
+			/// @brief Process start time in clock ticks after boot (from /proc/pid/stat).
+			/// @see Stat::starttime
+			/// Together with the pid it identifies the process, pids are reused
+			/// but a (pid,starttime) pair is not.
+			unsigned long long starttime = 0;
+
 			/// @brief Mutex for serialization.
 			static std::recursive_mutex guard;
 
@@ -78,14 +91,43 @@
 			// Swap use in % of total.
 			//
 
+			/// @brief Controller slot for the refresh values.
+			uint32_t slot = 0;
+
 			/// @brief CPU Usage in %.
 			struct {
 				float percent = 0;			///< @brief CPU usage on last check.
-				unsigned long last = 0;		///< @brief utime+stime got in the last refresh.
 			} cpu;
 
+			/// @brief Resident set size in bytes on last refresh.
+			unsigned long long rss = 0;
+
+			/// @brief Virtual memory size in bytes on last refresh.
+			unsigned long long vsize = 0;
+
+			/// @brief Block I/O delays, from blkio_ticks.
+			struct {
+				unsigned long long delta = 0;	///< @brief Delay ticks on the last refresh interval.
+				unsigned long long last = 0;	///< @brief blkio_ticks got in the last refresh.
+			} iowait;
+
+			/// @brief Agents bound to this process.
+			std::vector<Agent *> agents;
+
+			/// @brief Process properties, read on insert and on exec.
+			struct {
+				std::string exename;			///< @brief Executable path.
+				uid_t uid = (uid_t) -1;			///< @brief Real user id, (uid_t) -1 if not read yet.
+			} properties;
+
+			/// @brief Values on the last agent notification.
+			struct {
+				float cpu = 0;
+				unsigned long long rss = 0;
+			} notified;
+
 			/// @brief Current state
-			State state = (State) -1;
+			State state = Unknown;
 
 			/// @brief Set current state
 			void set(const State state);
@@ -94,11 +136,27 @@
 			void reset();
 
 		public:
-			Identifier(pid_t p) : pid(p) {
+			Identifier(pid_t pid);
+
+			Identifier(pid_t p, unsigned long long s) : pid(p), starttime(s) {
 			}
 
 			~Identifier();
 
+			/// @brief Get process start time without a full /proc/pid/stat parse.
+			/// @param pid The process id.
+			/// @return The process start time in clock ticks after boot, 0 if the process is not available.
+			static unsigned long long StartTime(pid_t pid) noexcept;
+
+			/// @brief Get the procfs mount point.
+			/// @brief Resolved on the controller start, the returned pointer is never released.
+			/// @return The procfs path, from [process] procfs in the configuration (default "/proc").
+			static const char * procfs();
+
+			/// @brief Set the procfs mount point, for synthetic process tables.
+			/// @param path The procfs path, should be set before the controller starts.
+			static void procfs(const char *path);
+
 			void get(Udjat::Value &value) const;
 
 			/// @brief Data from /proc/pid/stat.
@@ -186,7 +244,7 @@
 			}
 
 			constexpr bool operator==(const Identifier &entry) const {
-				return this->pid == entry.pid;
+				return this->pid == entry.pid && this->starttime == entry.starttime;
 			}
 
 			constexpr bool operator==(const State &state) const {
@@ -201,8 +259,46 @@
 				return this->pid;
 			}
 
+			inline unsigned long long getStartTime() const noexcept {
+				return this->starttime;
+			}
+
+			/// @brief Get process start time.
+			/// @return The process start time in seconds since the epoch.
+			time_t started() const;
+
+			/// @brief Check if the pid still refers to this process.
+			/// @return false if the process has finished or the pid was reused.
+			bool valid() const noexcept;
+
 			std::string exename() const;
 
+			/// @brief Get process executable path.
+			/// @param pid The process id.
+			/// @return The executable path, "pid<number>" if not available.
+			static std::string exename(pid_t pid);
+
+			/// @brief Get process command line.
+			/// @return The command line with arguments separated by spaces.
+			std::string cmdline() const;
+
+			/// @brief Get process command line.
+			/// @param pid The process id.
+			/// @return The command line with arguments separated by spaces, empty if not available.
+			static std::string cmdline(pid_t pid);
+
+			/// @brief Get process command name.
+			std::string comm() const;
+
+			/// @brief Get process command name.
+			/// @param pid The process id.
+			/// @return The command name, empty if not available.
+			static std::string comm(pid_t pid);
+
+			/// @brief Get process owner.
+			/// @return The real user id, (uid_t) -1 if the process is not available.
+			static uid_t uid(pid_t pid) noexcept;
+
 			State getState();
 
 			/// @brief Get CPU usage in %.
@@ -210,6 +306,35 @@
 				return (this->cpu.percent * 100);
 			}
 
+			/// @brief Get resident set size on last refresh.
+			inline unsigned long long getRSS() const noexcept {
+				return this->rss;
+			}
+
+			/// @brief Get virtual memory size on last refresh.
+			inline unsigned long long getVSize() const noexcept {
+				return this->vsize;
+			}
+
+			/// @brief Get the executable path read on insert (or exec), no procfs reads.
+			inline const std::string & getExeName() const noexcept {
+				return properties.exename;
+			}
+
+			/// @brief Get the real user id read on insert (or exec), no procfs reads.
+			inline uid_t getUid() const noexcept {
+				return properties.uid;
+			}
+
+			/// @brief Get block I/O delay on the last refresh interval.
+			/// @brief The time the process waited for block I/O, not the I/O volume; the kernel
+			/// @brief reports it only with delay accounting enabled (delayacct boot option or
+			/// @brief kernel.task_delayacct=1), otherwise it's always 0.
+			/// @return Block I/O delay in clock ticks (centiseconds).
+			inline unsigned long long getIOWait() const noexcept {
+				return this->iowait.delta;
+			}
+
 		};
 
 
@@ -0,0 +1,117 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ #pragma once
+
+ #include <udjat/defs.h>
+ #include <atomic>
+ #include <cstdint>
+ #include <cstring>
+ #include <vector>
+
+ namespace Udjat {
+
+	namespace Process {
+
+		/// @brief Binary layout of the per-process metrics exported in shared memory.
+		///
+		/// The file (see [process] shared-memory) holds a Header followed by
+		/// Header::capacity records; the first Header::count records are valid.
+		/// The writer increments Header::sequence before and after each update,
+		/// readers copy the records and retry if the sequence was odd or changed
+		/// (seqlock). Readers never write to the mapping.
+		namespace Shared {
+
+			static constexpr uint32_t Magic = 0x43525055;	///< @brief "UPRC".
+			static constexpr uint32_t Version = 1;
+
+			struct Record {
+				int32_t pid;				///< @brief Process id.
+				uint8_t state;				///< @brief Process state (Identifier::State).
+				uint8_t reserved[3];
+				float cpu;					///< @brief CPU usage on the last refresh, in %.
+				uint32_t padding;
+				uint64_t starttime;			///< @brief Start time, in clock ticks after boot.
+				uint64_t rss;				///< @brief Resident set size in bytes.
+				uint64_t vsize;				///< @brief Virtual memory size in bytes.
+			};
+
+			struct Header {
+				uint32_t magic;					///< @brief Magic.
+				uint32_t version;				///< @brief Layout version.
+				uint32_t header;				///< @brief sizeof(Header), offset of the first record.
+				uint32_t record;				///< @brief sizeof(Record).
+				uint32_t capacity;				///< @brief Number of records in the file.
+				uint32_t count;					///< @brief Number of valid records.
+				uint32_t total;					///< @brief Number of processes (above capacity if truncated).
+				float cpu;						///< @brief System CPU usage on the last refresh, in %.
+				std::atomic<uint64_t> sequence;	///< @brief Seqlock, odd while the writer is updating.
+				uint64_t generation;			///< @brief Refresh counter.
+				uint64_t timestamp;				///< @brief Refresh time, in milliseconds since the epoch.
+				uint64_t reserved;
+			};
+
+			static_assert(sizeof(Record) == 40, "Unexpected record size");
+			static_assert(sizeof(Header) == 64, "Unexpected header size");
+			static_assert(std::atomic<uint64_t>::is_always_lock_free, "Sequence must be lock free");
+
+			/// @brief Copy a consistent snapshot from a mapped export.
+			/// @param header The mapped file.
+			/// @param records The valid records (storage is reused).
+			/// @param retries Maximum attempts while the writer is updating.
+			/// @return The snapshot generation, 0 if no consistent snapshot was read.
+			inline uint64_t snapshot(const Header &header, std::vector<Record> &records, unsigned int retries = 100) {
+
+				const Record *source = (const Record *) (((const uint8_t *) &header) + header.header);
+
+				while(retries--) {
+
+					uint64_t sequence = header.sequence.load(std::memory_order_acquire);
+					if(sequence & 1) {
+						continue;
+					}
+
+					uint32_t count = header.count;
+					if(count > header.capacity) {
+						continue;
+					}
+
+					uint64_t generation = header.generation;
+
+					records.resize(count);
+					memcpy(records.data(),source,count * sizeof(Record));
+
+					std::atomic_thread_fence(std::memory_order_acquire);
+					if(header.sequence.load(std::memory_order_relaxed) == sequence) {
+						return generation;
+					}
+
+				}
+
+				records.clear();
+				return 0;
+
+			}
+
+		}
+
+	}
+
+ }
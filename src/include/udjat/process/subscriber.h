@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ #pragma once
+
+ #include <udjat/defs.h>
+ #include <udjat/process/identifier.h>
+
+ namespace Udjat {
+
+	namespace Process {
+
+		class Agent;
+
+		/// @brief Receives process transitions right after the controller detects them.
+		///
+		/// Callbacks run with the controller lock held, on the refresh or on
+		/// the event dispatcher; they must be short and must not block. They
+		/// can subscribe or unsubscribe, the change applies from the next event.
+		class UDJAT_API Subscriber {
+		private:
+			/// @brief Is there any subscription? (changed with the controller lock held)
+			bool subscribed = false;
+
+		public:
+			Subscriber() = default;
+			Subscriber(const Subscriber &) = delete;
+
+			virtual ~Subscriber();
+
+			/// @brief Subscribe to state transitions, and to all bind/unbind events.
+			/// @param from The previous state, Undefined for any.
+			/// @param to The new state, Undefined for any.
+			void subscribe(Identifier::State from = Identifier::Undefined, Identifier::State to = Identifier::Undefined);
+
+			/// @brief Cancel all subscriptions.
+			/// @brief Without subscriptions it returns at once, never touching the controller.
+			void unsubscribe() noexcept;
+
+			/// @brief Process state changed.
+			/// @param identifier The process.
+			/// @param from The previous state, Undefined for a new process.
+			/// @param to The new state, Undefined for a removed process.
+			virtual void changed(const Identifier &identifier, Identifier::State from, Identifier::State to);
+
+			/// @brief Agent was bound to a process.
+			virtual void bound(const Agent &agent, const Identifier &identifier);
+
+			/// @brief Agent was unbound from a process.
+			virtual void unbound(const Agent &agent, const Identifier &identifier);
+
+		};
+
+	}
+
+ }
@@ -20,6 +20,7 @@
  #include "private.h"
  #include <controller.h>
  #include <udjat/tools/system/info.h>
+ #include <udjat/tools/xml.h>
 
  namespace Udjat {
 
@@ -42,10 +43,71 @@
 		throw system_error(EINVAL, system_category(),"Invalid field name");
 	}
 
+	const char * Process::Agent::selectionNames[] = {
+		"cpu",
+		"rss",
+		"vsize",
+		"mode",
+		"history",
+		"instances",
+		"signals"
+	};
+
+	uint8_t Process::Agent::getSelection(const Request &request) {
+
+		string fields = request.getArgument("fields");
+
+		if(fields.empty()) {
+			return SelectAll;
+		}
+
+		uint8_t selection = 0;
+		size_t from = 0;
+
+		while(from <= fields.size()) {
+
+			size_t to = fields.find(',',from);
+			if(to == string::npos) {
+				to = fields.size();
+			}
+
+			string name = fields.substr(from,to-from);
+			name.erase(0,name.find_first_not_of(' '));
+			name.erase(name.find_last_not_of(' ')+1);
+
+			if(!name.empty()) {
+
+				size_t ix = 0;
+				while(ix < N_ELEMENTS(selectionNames) && strcasecmp(name.c_str(),selectionNames[ix])) {
+					ix++;
+				}
+
+				if(ix == N_ELEMENTS(selectionNames)) {
+					throw system_error(EINVAL, system_category(),string{"Invalid field name '"} + name + "'");
+				}
+
+				selection |= (1 << ix);
+
+			}
+
+			from = to + 1;
+		}
+
+		return selection;
+
+	}
+
 	Process::Agent::Agent() {
 	}
 
 	Process::Agent::Agent(const pugi::xml_node &node) : Abstract::Agent(node) {
+
+		size_t length = Attribute(node,"history-length").as_uint(0);
+
+		if(length) {
+			history.reset(new History(length,Attribute(node,"history-alpha").as_float(0.2)));
+		}
+
 	}
 
 	Process::Agent::~Agent() {
@@ -69,6 +131,10 @@
 		return probe(exe.c_str());
 	}
 
+	bool Process::Agent::index(Matcher UDJAT_UNUSED(&matcher)) {
+		return false;
+	}
+
 	Process::Identifier::State Process::Agent::getState() const noexcept {
 
 		if(pid) {
@@ -95,13 +161,64 @@
 
 		super::get(request,response);
 
+		// Values from the last refresh, no /proc reads.
+		uint8_t selection = getSelection(request);
+
+		if(selection & SelectCPU) {
+			response["cpu"].setFraction(getCPU() / 100);
+		}
+
+		if(selection & SelectVSize) {
+			response["vsize"] = getVSize();
+		}
+
+		if(selection & SelectRSS) {
+			response["rss"] = getRSS();
+		}
+
+		if(selection & SelectMode) {
+			response["mode"] = Identifier::StateNameFactory(getState()).name;
+		}
+
+		if(history && (selection & SelectHistory)) {
+			history->get(response["history"]);
+		}
+
+		if(selection & SelectSignals) {
+			response["coredumps"] = signals.coredumps;
+			response["ptraces"] = signals.ptraces;
+		}
+
+	}
+
+	void Process::Agent::sample() {
+
+		if(!history) {
+			return;
+		}
+
+		float values[History::MetricCount];
+
+		values[History::CPU] = getCPU();
+
 		if(pid) {
-			pid->get(response);
-			Identifier::Stat(pid).get(response);
+
+			// From the last refresh, no /proc reads.
+			values[History::RSS] = (float) pid->getRSS();
+			values[History::VSize] = (float) pid->getVSize();
+			values[History::IOWait] = (float) pid->getIOWait();
+
 		} else {
-			Identifier::Stat().get(response);
+
+			// Not bound or aggregated.
+			values[History::RSS] = (float) getRSS();
+			values[History::VSize] = (float) getValue(VSize);
+			values[History::IOWait] = 0;
+
 		}
 
+		history->push(values);
+
 	}
 
 	/*
@@ -112,12 +229,41 @@
 
 	void Process::Agent::set(const pid_t pid) {
 
+		Process::Controller &controller = Process::Controller::getInstance();
+
 		if(pid < 0) {
-			set((Identifier *) nullptr);
+			controller.set(this,nullptr);
 		} else {
-			set(Process::Controller::getInstance().find(pid));
+			controller.set(this,controller.find(pid));
+		}
+
+	}
+
+	bool Process::Agent::bind(Identifier *ident) {
+		set(ident);
+		return true;
+	}
+
+	void Process::Agent::unbind(Identifier *ident) {
+		if(pid == ident) {
+			set((Identifier *) nullptr);
 		}
+	}
 
+	void Process::Agent::changed(const Identifier UDJAT_UNUSED(&ident), float UDJAT_UNUSED(cpu), unsigned long long UDJAT_UNUSED(rss)) {
+	}
+
+	void Process::Agent::coredump(const Identifier &ident) {
+		signals.coredumps++;
+		signals.crashed = true;
+		warning() << "Coredump on pid '" << ident.getPid() << "'" << endl;
+	}
+
+	void Process::Agent::ptrace(const Identifier &ident, pid_t tracer) {
+		if(tracer) {
+			signals.ptraces++;
+			info() << "Pid '" << ident.getPid() << "' traced by '" << tracer << "'" << endl;
+		}
 	}
 
 	void Process::Agent::set(Identifier *pid) {
@@ -158,14 +304,14 @@
 		if(!pid) {
 			return 0;
 		}
-		return Identifier::Stat(pid).getRSS();
+		return pid->getRSS();
 	}
 
 	unsigned long long Process::Agent::getVSize() const {
 		if(!pid) {
 			return 0;
 		}
-		return Identifier::Stat(pid).getVSize();
+		return pid->getVSize();
 	}
 
 	unsigned long long Process::Agent::getShared() const {
@@ -181,17 +327,15 @@
 			return 0;
 		}
 
-		Identifier::Stat stat(pid);
-
 		switch(field) {
 		case Rss:
-			return stat.getRSS();
+			return pid->getRSS();
 
 		case VSize:
-			return stat.getVSize();
+			return pid->getVSize();
 
 		case Shared:
-			return stat.getShared();
+			return Identifier::Stat(pid).getShared();
 
 		default:
 			throw runtime_error("Unexpected field id");
@@ -205,14 +349,12 @@
 			return 0;
 		}
 
-		Identifier::Stat stat(pid);
-
 		switch(field) {
 		case Rss:
 
 			// RSS - Return resident pages / totalram.
 			{
-				float value = (float) stat.getRSS();
+				float value = (float) pid->getRSS();
 
 				if(value > 0) {
 					return  value / ((float) Udjat::System::Info().totalram);
@@ -226,7 +368,7 @@
 			// VSize - Return APP VSize / (totalram + totalswap)
 			{
 				Udjat::System::Info info;
-				float value = (float) stat.getVSize();
+				float value = (float) pid->getVSize();
 
 				if(value > 0) {
 					return value / ((float) (info.totalram + info.totalswap));
@@ -238,7 +380,7 @@
 
 			// Shared  - Return APP Shared / totalshared
 			{
-				float value = (float) stat.getShared();
+				float value = (float) Identifier::Stat(pid).getShared();
 
 				if(value > 0) {
 					return  value / ((float) Udjat::System::Info().sharedram);
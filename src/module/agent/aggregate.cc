@@ -0,0 +1,219 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ #include "private.h"
+ #include <udjat/tools/logger.h>
+ #include <mutex>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	template <class T>
+	bool Process::Aggregate<T>::bind(Identifier *ident) {
+
+		size_t count;
+
+		{
+			lock_guard<mutex> lock(guard);
+
+			if(!instances.insert(ident).second) {
+				return true;
+			}
+
+			total.dirty = true;
+			count = instances.size();
+		}
+
+		this->info() << "Detected on pid '" << ((pid_t) *ident) << "', " << count << " instance(s)" << endl;
+
+		this->updated(true);
+		return true;
+
+	}
+
+	template <class T>
+	void Process::Aggregate<T>::unbind(Identifier *ident) {
+
+		bool empty;
+
+		{
+			lock_guard<mutex> lock(guard);
+
+			if(!instances.erase(ident)) {
+				return;
+			}
+
+			total.dirty = true;
+			empty = instances.empty();
+		}
+
+		if(empty) {
+			this->info() << "Not available" << endl;
+		}
+
+		this->updated(true);
+
+	}
+
+	template <class T>
+	void Process::Aggregate<T>::changed(const Identifier UDJAT_UNUSED(&ident), float UDJAT_UNUSED(cpu), unsigned long long UDJAT_UNUSED(rss)) {
+		lock_guard<mutex> lock(guard);
+		total.dirty = true;
+	}
+
+	template <class T>
+	void Process::Aggregate<T>::sum() const noexcept {
+
+		if(!total.dirty) {
+			return;
+		}
+
+		// Summed from the instances, running deltas would accumulate rounding errors.
+		total.cpu = 0;
+		total.rss = 0;
+		for(auto instance : instances) {
+			total.cpu += instance->getCPU();
+			total.rss += instance->getRSS();
+		}
+
+		total.dirty = false;
+
+	}
+
+	template <class T>
+	void Process::Aggregate<T>::get(const Request &request, Response &response) {
+
+		Abstract::Agent::get(request,response);
+
+		uint8_t selection = Process::Agent::getSelection(request);
+
+		{
+			lock_guard<mutex> lock(guard);
+			sum();
+
+			if(selection & Process::Agent::SelectInstances) {
+				response["instances"] = (unsigned int) instances.size();
+			}
+
+			if(selection & Process::Agent::SelectCPU) {
+				response["cpu"].setFraction(total.cpu / 100);
+			}
+
+			if(selection & Process::Agent::SelectRSS) {
+				response["rss"] = total.rss;
+			}
+
+			if(selection & Process::Agent::SelectMode) {
+				response["mode"] = Process::Identifier::StateNameFactory(state()).name;
+			}
+		}
+
+		if(this->getHistory() && (selection & Process::Agent::SelectHistory)) {
+			this->getHistory()->get(response["history"]);
+		}
+
+		if(selection & Process::Agent::SelectSignals) {
+			response["coredumps"] = this->getCoredumps();
+			response["ptraces"] = this->getPtraces();
+		}
+
+	}
+
+	template <class T>
+	Process::Identifier::State Process::Aggregate<T>::state() const noexcept {
+
+		if(instances.empty()) {
+			return Process::Identifier::Dead;
+		}
+
+		// The most active state of the instances, in this order.
+		static const Process::Identifier::State precedence[] = {
+			Process::Identifier::Running,
+			Process::Identifier::Sleeping,
+			Process::Identifier::Waiting,
+			Process::Identifier::Parked,
+			Process::Identifier::Paging,
+			Process::Identifier::Wakekill,
+			Process::Identifier::Stopped,
+			Process::Identifier::TracingStop,
+			Process::Identifier::Zombie,
+			Process::Identifier::Dead,
+			Process::Identifier::DeadCompat
+		};
+
+		size_t selected = N_ELEMENTS(precedence);
+
+		for(auto instance : instances) {
+
+			Process::Identifier::State state = instance->getState();
+
+			for(size_t ix = 0; ix < selected; ix++) {
+				if(precedence[ix] == state) {
+					selected = ix;
+					break;
+				}
+			}
+
+			if(!selected) {
+				break;
+			}
+
+		}
+
+		return selected < N_ELEMENTS(precedence) ? precedence[selected] : Process::Identifier::Undefined;
+
+	}
+
+	template <class T>
+	Process::Identifier::State Process::Aggregate<T>::getState() const noexcept {
+		lock_guard<mutex> lock(guard);
+		return state();
+	}
+
+	template <class T>
+	float Process::Aggregate<T>::getCPU() const noexcept {
+		lock_guard<mutex> lock(guard);
+		sum();
+		return total.cpu;
+	}
+
+	template <class T>
+	unsigned long long Process::Aggregate<T>::getRSS() const {
+		lock_guard<mutex> lock(guard);
+		sum();
+		return total.rss;
+	}
+
+	template <class T>
+	unsigned long long Process::Aggregate<T>::getValue(Process::Agent::Field field) const {
+
+		if(field == Process::Agent::Rss) {
+			return getRSS();
+		}
+
+		// Only CPU and RSS are aggregated.
+		return 0;
+
+	}
+
+	template class Process::Aggregate<Process::ExeNameAgent>;
+	template class Process::Aggregate<Process::PatternAgent>;
+
+ }
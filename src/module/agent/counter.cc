@@ -26,11 +26,32 @@
 	}
 
 	void Process::StateCounterAgent::start() {
-		super::start(Process::Controller::getInstance().count(state));
+		// Transitions after the subscription are already on the counter.
+		counter += (unsigned int) Process::Controller::getInstance().count(state,this);
+		super::start(counter.load());
+	}
+
+	void Process::StateCounterAgent::stop() {
+		unsubscribe();
+		counter = 0;
+		super::stop();
+	}
+
+	void Process::StateCounterAgent::changed(const Identifier UDJAT_UNUSED(&identifier), Identifier::State from, Identifier::State to) {
+
+		if(from == state) {
+			counter--;
+		}
+
+		if(to == state) {
+			counter++;
+		}
+
 	}
 
 	bool Process::StateCounterAgent::refresh() {
-		return set(Process::Controller::getInstance().count(state));
+		// No process scan, the counter follows the transitions.
+		return set(counter.load());
 	}
 
  }
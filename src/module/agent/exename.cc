@@ -32,5 +32,10 @@
 		return false;
 	}
 
+	bool Process::ExeNameAgent::index(Matcher &matcher) {
+		matcher.insert(this,Matcher::ExeName,exename);
+		return true;
+	}
+
  }
 
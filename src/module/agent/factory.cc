@@ -23,6 +23,18 @@
 
  namespace Udjat {
 
+	/// @brief Build agent for the first matching process or, with instances='all', for all of them.
+	template <class T, typename... Args>
+	static std::shared_ptr<Abstract::Agent> SelectorFactory(const pugi::xml_node &node, Args... args) {
+
+		if(!strcasecmp(Attribute(node,"instances").as_string("first"),"all")) {
+			return make_shared<Process::Aggregate<T>>(args..., node);
+		}
+
+		return make_shared<T>(args..., node);
+
+	}
+
 	std::shared_ptr<Abstract::Agent> Process::Agent::AgentFactory(const pugi::xml_node &node) {
 
 		// Process by exename
@@ -30,7 +42,38 @@
 			const char *exename = Attribute(node,"exename").as_string();
 
 			if(exename && *exename) {
-				return make_shared<ExeNameAgent>(Quark(exename).c_str(), node);
+
+				// Interpreters: select by command line, but only on processes running exename.
+				const char *cmdline = Attribute(node,"cmdline-pattern").as_string();
+
+				if(cmdline && *cmdline) {
+					return SelectorFactory<PatternAgent>(node, Matcher::CmdLine, Quark(cmdline).c_str(), Quark(exename).c_str());
+				}
+
+				return SelectorFactory<ExeNameAgent>(node, Quark(exename).c_str());
+			}
+
+		}
+
+		// Process by pattern
+		{
+			static const struct {
+				const char *attribute;
+				Matcher::Field field;
+			} selectors[] = {
+				{ "exename-pattern",	Matcher::ExeName	},
+				{ "cmdline-pattern",	Matcher::CmdLine	},
+				{ "comm",				Matcher::Comm		},
+			};
+
+			for(auto &selector : selectors) {
+
+				const char *pattern = Attribute(node,selector.attribute).as_string();
+
+				if(pattern && *pattern) {
+					return SelectorFactory<PatternAgent>(node, selector.field, Quark(pattern).c_str());
+				}
+
 			}
 
 		}
@@ -45,6 +88,31 @@
 
 		}
 
+		// Top consumers.
+		{
+			const char *resource = Attribute(node,"top").as_string();
+
+			if(resource && *resource) {
+				return make_shared<TopAgent>(resource, node);
+			}
+
+		}
+
+		// Module internals.
+		{
+			const char *internal = Attribute(node,"internal").as_string();
+
+			if(internal && *internal) {
+
+				if(strcasecmp(internal,"controller")) {
+					throw system_error(EINVAL, system_category(),"Invalid internal agent name");
+				}
+
+				return make_shared<ControllerAgent>(node);
+			}
+
+		}
+
 		// State counter.
 		{
 			const char *state = Attribute(node,"process-state").as_string();
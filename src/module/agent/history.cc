@@ -0,0 +1,230 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ #include <config.h>
+ #include <udjat/defs.h>
+ #include <udjat/process/history.h>
+ #include <algorithm>
+ #include <cmath>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	const char * Process::History::metricNames[] = {
+		"cpu",
+		"rss",
+		"vsize",
+		"iowait"
+	};
+
+	const char * Process::History::statisticNames[] = {
+		"last",
+		"min",
+		"max",
+		"mean",
+		"ewma",
+		"percentile"
+	};
+
+	Process::History::Metric Process::History::MetricFactory(const char *name) {
+
+		for(size_t ix = 0; ix < N_ELEMENTS(metricNames); ix++) {
+
+			if(!strcasecmp(name,metricNames[ix])) {
+				return (Metric) ix;
+			}
+
+		}
+
+		throw system_error(EINVAL, system_category(),"Invalid metric name");
+	}
+
+	Process::History::Statistic Process::History::StatisticFactory(const char *name, float &percentile) {
+
+		if((name[0] == 'p' || name[0] == 'P') && isdigit(name[1])) {
+
+			percentile = atof(name+1);
+			if(percentile < 0 || percentile > 100) {
+				throw system_error(EINVAL, system_category(),"Percentile should be from 0 to 100");
+			}
+
+			return Percentile;
+		}
+
+		for(size_t ix = 0; ix < N_ELEMENTS(statisticNames); ix++) {
+
+			if(!strcasecmp(name,statisticNames[ix])) {
+				return (Statistic) ix;
+			}
+
+		}
+
+		throw system_error(EINVAL, system_category(),"Invalid statistic name");
+	}
+
+	Process::History::History(size_t length, float a) : alpha(a) {
+
+		if(!length) {
+			throw system_error(EINVAL, system_category(),"History length should be at least one sample");
+		}
+
+		if(alpha <= 0 || alpha > 1) {
+			throw system_error(EINVAL, system_category(),"EWMA factor should be from 0 to 1");
+		}
+
+		for(auto &item : series) {
+			item.setup(length);
+		}
+
+	}
+
+	void Process::History::push(const float values[MetricCount]) {
+		lock_guard<mutex> lock(guard);
+		for(size_t metric = 0; metric < MetricCount; metric++) {
+			series[metric].push(values[metric],alpha);
+		}
+	}
+
+	float Process::History::get(const Metric metric, const Statistic statistic, float percentile) const {
+		lock_guard<mutex> lock(guard);
+		return series[metric].get(statistic,percentile);
+	}
+
+	void Process::History::get(Udjat::Value &value) const {
+
+		lock_guard<mutex> lock(guard);
+
+		for(size_t metric = 0; metric < MetricCount; metric++) {
+
+			Value &item = value[metricNames[metric]];
+			const Series &current = series[metric];
+
+			item["min"] = current.get(Min,0);
+			item["max"] = current.get(Max,0);
+			item["mean"] = current.get(Mean,0);
+			item["ewma"] = current.get(EWMA,0);
+			item["p50"] = current.get(Percentile,50);
+			item["p95"] = current.get(Percentile,95);
+
+		}
+
+	}
+
+	void Process::History::Series::setup(size_t length) {
+		values.assign(length,0);
+		scratch.reserve(length);
+		minimum.setup(length);
+		maximum.setup(length);
+	}
+
+	void Process::History::Series::Wedge::setup(size_t length) {
+		items.assign(length,0);
+		first = count = 0;
+	}
+
+	void Process::History::Series::Wedge::expire(uint64_t sequence) {
+		while(count && items[first] < sequence) {
+			first = (first+1) % items.size();
+			count--;
+		}
+	}
+
+	void Process::History::Series::push(float value, float alpha) {
+
+		size_t length = values.size();
+		float &slot = values[sequence % length];
+
+		if(sequence >= length) {
+
+			// Window is full, drop the oldest sample.
+			sum -= slot;
+
+			uint64_t oldest = sequence - length + 1;
+			minimum.expire(oldest);
+			maximum.expire(oldest);
+
+			ewma += alpha * (value - ewma);
+
+		} else if(sequence) {
+
+			ewma += alpha * (value - ewma);
+
+		} else {
+
+			ewma = value;
+
+		}
+
+		slot = value;
+		sum += value;
+
+		minimum.push(values,sequence,[](float value, float current) {
+			return value <= current;
+		});
+
+		maximum.push(values,sequence,[](float value, float current) {
+			return value >= current;
+		});
+
+		sequence++;
+
+	}
+
+	float Process::History::Series::get(Statistic statistic, float percentile) const {
+
+		size_t count = size();
+
+		if(!count) {
+			return 0;
+		}
+
+		switch(statistic) {
+		case Last:
+			return values[(sequence-1) % values.size()];
+
+		case Min:
+			return values[minimum.front() % values.size()];
+
+		case Max:
+			return values[maximum.front() % values.size()];
+
+		case Mean:
+			return (float) (sum / count);
+
+		case EWMA:
+			return ewma;
+
+		case Percentile:
+			{
+				scratch.assign(values.begin(),values.begin()+count);
+
+				size_t pos = (size_t) round((percentile / 100) * (count-1));
+				nth_element(scratch.begin(),scratch.begin()+pos,scratch.end());
+
+				return scratch[pos];
+			}
+
+		}
+
+		return 0;
+
+	}
+
+ }
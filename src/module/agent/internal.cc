@@ -0,0 +1,181 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ #include "private.h"
+ #include <unistd.h>
+ #include <fcntl.h>
+ #include <sys/time.h>
+ #include <sys/resource.h>
+
+ namespace Udjat {
+
+	/// @brief Get CPU time of this process in microseconds.
+	static unsigned long long cputime() {
+
+		struct rusage usage;
+		if(getrusage(RUSAGE_SELF,&usage)) {
+			return 0;
+		}
+
+		return
+			((unsigned long long) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)) * 1000000
+			+ usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+
+	}
+
+	/// @brief Get resident set size of this process in bytes.
+	static unsigned long long resident() {
+
+		// The module process, not the (maybe synthetic) monitored procfs.
+		int fd = open("/proc/self/statm",O_RDONLY);
+		if(fd < 0) {
+			return 0;
+		}
+
+		char buffer[128];
+		ssize_t sz = read(fd,buffer,sizeof(buffer)-1);
+		::close(fd);
+
+		if(sz <= 0) {
+			return 0;
+		}
+		buffer[sz] = 0;
+
+		unsigned long size = 0, pages = 0;
+		if(sscanf(buffer,"%lu %lu",&size,&pages) != 2) {
+			return 0;
+		}
+
+		return ((unsigned long long) pages) * sysconf(_SC_PAGESIZE);
+
+	}
+
+	Process::ControllerAgent::ControllerAgent(const pugi::xml_node &node) : Udjat::Agent<float>(node) {
+
+		auto &metrics = Controller::metrics;
+
+		last.time = chrono::steady_clock::now();
+		for(size_t ix = 0; ix < Controller::EventTypeCount; ix++) {
+			last.events[ix] = metrics.events[ix].load(memory_order_relaxed);
+			current.events[ix] = 0;
+		}
+		last.locks = metrics.lock.count.load(memory_order_relaxed);
+		last.wait = metrics.lock.wait.load(memory_order_relaxed);
+		last.hold = metrics.lock.hold.load(memory_order_relaxed);
+		last.cpu = cputime();
+
+	}
+
+	void Process::ControllerAgent::sample() {
+
+		auto &metrics = Controller::metrics;
+
+		lock_guard<mutex> lock(guard);
+
+		auto now = chrono::steady_clock::now();
+		double seconds = chrono::duration<double>(now - last.time).count();
+		if(seconds <= 0) {
+			return;
+		}
+
+		for(size_t ix = 0; ix < Controller::EventTypeCount; ix++) {
+			unsigned long long events = metrics.events[ix].load(memory_order_relaxed);
+			current.events[ix] = (float) ((events - last.events[ix]) / seconds);
+			last.events[ix] = events;
+		}
+
+		unsigned long long locks = metrics.lock.count.load(memory_order_relaxed);
+		unsigned long long wait = metrics.lock.wait.load(memory_order_relaxed);
+		unsigned long long hold = metrics.lock.hold.load(memory_order_relaxed);
+
+		current.locks = (float) ((locks - last.locks) / seconds);
+		if(locks != last.locks) {
+			current.wait = ((float) (wait - last.wait)) / (locks - last.locks) / 1000;
+			current.hold = ((float) (hold - last.hold)) / (locks - last.locks) / 1000;
+		} else {
+			current.wait = current.hold = 0;
+		}
+
+		last.locks = locks;
+		last.wait = wait;
+		last.hold = hold;
+
+		unsigned long long cpu = cputime();
+		current.cpu = (float) (((cpu - last.cpu) / (seconds * 10000)) / sysconf(_SC_NPROCESSORS_ONLN));
+		last.cpu = cpu;
+
+		current.rss = resident();
+		last.time = now;
+
+	}
+
+	void Process::ControllerAgent::start() {
+		sample();
+		super::start(((float) Controller::metrics.duration.load(memory_order_relaxed)) / 1000);
+	}
+
+	bool Process::ControllerAgent::refresh() {
+		sample();
+		return set(((float) Controller::metrics.duration.load(memory_order_relaxed)) / 1000);
+	}
+
+	void Process::ControllerAgent::get(const Request &request, Response &response) {
+
+		super::get(request,response);
+
+		auto &metrics = Controller::metrics;
+
+		lock_guard<mutex> lock(guard);
+
+		Value &controller = response["controller"];
+
+		controller["refreshes"] = (unsigned long long) metrics.refreshes.load(memory_order_relaxed);
+		controller["refresh-time"] = (unsigned long long) metrics.duration.load(memory_order_relaxed);
+		controller["identifiers"] = (unsigned long long) Controller::getInstance().size();
+		controller["files-per-cycle"] = (unsigned long long) metrics.cycle.load(memory_order_relaxed);
+		controller["files"] = (unsigned long long) metrics.files.load(memory_order_relaxed);
+		controller["coalesced"] = (unsigned long long) metrics.coalesced.load(memory_order_relaxed);
+		controller["merged"] = (unsigned long long) metrics.merged.load(memory_order_relaxed);
+		controller["overloads"] = (unsigned long long) metrics.overloads.load(memory_order_relaxed);
+
+		{
+			const auto &counters = Controller::getInstance().getPool().counters;
+			Value &pool = controller["pool"];
+			pool["used"] = (unsigned long long) counters.used.load(memory_order_relaxed);
+			pool["high"] = (unsigned long long) counters.high.load(memory_order_relaxed);
+			pool["capacity"] = (unsigned long long) counters.capacity.load(memory_order_relaxed);
+		}
+
+		Value &events = controller["events"];
+		for(size_t ix = 0; ix < Controller::EventTypeCount; ix++) {
+			events[Controller::eventTypeNames[ix]] = current.events[ix];
+		}
+
+		Value &locks = controller["lock"];
+		locks["rate"] = current.locks;
+		locks["wait"] = current.wait;
+		locks["hold"] = current.hold;
+
+		controller["cpu"].setFraction(current.cpu / 100);
+		controller["rss"] = current.rss;
+
+	}
+
+ }
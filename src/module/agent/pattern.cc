@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ #include "private.h"
+ #include <fnmatch.h>
+
+ namespace Udjat {
+
+	Process::PatternAgent::PatternAgent(Matcher::Field f, const char *p, const pugi::xml_node &node) : Process::Agent(node), field(f), pattern(p) {
+	}
+
+	Process::PatternAgent::PatternAgent(Matcher::Field f, const char *p, const char *e, const pugi::xml_node &node) : Process::Agent(node), field(f), pattern(p), exename(e) {
+	}
+
+	bool Process::PatternAgent::probe(const char *name) const noexcept {
+
+		if(exename && strcasecmp(name,exename)) {
+			return false;
+		}
+
+		return field == Matcher::ExeName && fnmatch(pattern,name,FNM_CASEFOLD) == 0;
+	}
+
+	bool Process::PatternAgent::probe(const Identifier &ident) const noexcept {
+
+		try {
+
+			Matcher::Subject subject{ident};
+
+			if(exename && strcasecmp(subject[Matcher::ExeName].c_str(),exename)) {
+				return false;
+			}
+
+			return Matcher::test(subject,field,pattern);
+
+		} catch(...) {
+
+			return false;
+
+		}
+
+	}
+
+	bool Process::PatternAgent::index(Matcher &matcher) {
+		matcher.insert(this,field,pattern,exename);
+		return true;
+	}
+
+ }
@@ -18,50 +18,238 @@
  */
 
  #include "private.h"
+ #include <controller.h>
  #include <unistd.h>
  #include <iostream>
  #include <fstream>
+ #include <sys/inotify.h>
+ #include <sys/stat.h>
+ #include <limits.h>
 
  namespace Udjat {
 
-	Process::PidFileAgent::PidFileAgent(const char *filename, const pugi::xml_node &node) : Process::Agent(node), pidfile(filename) {
+	Process::PidFileAgent::PidFileAgent(const char *filename, const pugi::xml_node &node) : Process::Agent(node), pidfile(filename), watcher(*this) {
+		watcher.interval = node.attribute("pidfile-retry").as_uint(10) * 1000;
 	}
 
 	bool Process::PidFileAgent::probe(const char UDJAT_UNUSED(*exename)) const noexcept {
 		return false;
 	}
 
+	bool Process::PidFileAgent::probe(const Identifier UDJAT_UNUSED(&ident)) const noexcept {
+		// No exename reads when registering on the controller.
+		return false;
+	}
+
+	bool Process::PidFileAgent::index(Matcher UDJAT_UNUSED(&matcher)) {
+		// Bound from pidfile, never by process properties.
+		return true;
+	}
+
 	void Process::PidFileAgent::start() {
-		refresh();
+
+		// Registered on the controller for history, timed states and
+		// notifications; index() keeps it from being probed.
+		Process::Agent::start();
+
+		watcher.start();
+		load();
+
+	}
+
+	void Process::PidFileAgent::load() {
+
+		ifstream pf;
+		pf.open(pidfile);
+
+		if(!pf.is_open()) {
+			// No pidfile, the process is not available.
+			Process::Controller::getInstance().set(this,nullptr);
+			return;
+		}
+
+		// Found pidfile, read it!
+		unsigned int pid = 0;
+		pf >> pid;
+		pf.close();
+
+		struct stat st;
+		if(::stat(pidfile,&st)) {
+			memset(&st,0,sizeof(st));
+		}
+
+		if(!pid) {
+			return;
+		}
+
+		const Identifier *current = getPid();
+		if(current && current->getPid() == (pid_t) pid && current->valid()) {
+			return;
+		}
+
+		info() << "Got '" << pid << "' from '" << pidfile << "'" << endl;
+
+		Identifier *identifier = Process::Controller::getInstance().find((pid_t) pid);
+
+		if(identifier) {
+
+			// The same pidfile naming the same pid with another start time: the
+			// process who wrote it is gone and the pid was reused. A rewritten
+			// pidfile (new inode or mtime) is a restart and always trusted.
+			bool rewritten =
+				st.st_ino != identity.inode
+				|| st.st_mtim.tv_sec != identity.mtime.tv_sec
+				|| st.st_mtim.tv_nsec != identity.mtime.tv_nsec;
+
+			if(!rewritten && identity.pid == (pid_t) pid && identity.starttime != identifier->getStartTime()) {
+
+				info() << "Ignoring stale pid '" << pid << "' from '" << pidfile << "'" << endl;
+				identifier = nullptr;
+
+			} else {
+
+				identity.pid = (pid_t) pid;
+				identity.starttime = identifier->getStartTime();
+				identity.inode = st.st_ino;
+				identity.mtime = st.st_mtim;
+
+			}
+
+		}
+
+		Process::Controller::getInstance().set(this,identifier);
+
+	}
+
+	Process::PidFileAgent::Watcher::Watcher(PidFileAgent &a) : Handler(-1,Handler::oninput), agent(a) {
+
+		const char *ptr = strrchr(agent.pidfile,'/');
+		name = (ptr ? ptr+1 : agent.pidfile);
+
+	}
+
+	Process::PidFileAgent::Watcher::~Watcher() {
+		retry.disable();
+		close();
+	}
+
+	void Process::PidFileAgent::Watcher::Retry::on_timer() {
+
+		watcher.start();
+
+		if(!watcher.retry.enabled()) {
+			// Watching, the pidfile may be there already.
+			watcher.load();
+		}
+
 	}
 
-	bool Process::PidFileAgent::refresh() {
+	void Process::PidFileAgent::Watcher::load() noexcept {
+
+		try {
 
-		if(!getPid()) {
+			agent.load();
 
-			// Check for pidfile.
-			if(access(pidfile,R_OK) == 0) {
+		} catch(const exception &e) {
 
-				ifstream pf;
-				pf.open(pidfile);
+			cerr << "Error '" << e.what() << "' loading '" << agent.pidfile << "'" << endl;
 
-				// Found pidfile, read it!
-				unsigned int pid = 0;
-				pf >> pid;
-				pf.close();
+		}
+
+	}
+
+	void Process::PidFileAgent::Watcher::start() {
+
+		if(fd >= 0) {
+			return;
+		}
 
-				if(pid) {
-					info() << "Got '" << pid << "' from '" << pidfile << "'" << endl;
-					set((pid_t) pid);
+		// Watch the pidfile directory; the pidfile itself can be removed,
+		// rotated or replaced by a rename, and a watch on its inode would
+		// be lost on the first daemon restart.
+		string path{agent.pidfile,(size_t) (name - agent.pidfile)};
+		if(path.empty()) {
+			path = ".";
+		}
+
+		fd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+		if(fd < 0) {
+			cerr << "Error '" << strerror(errno) << "' initializing inotify, pidfile will not be watched" << endl;
+			return;
+		}
+
+		if(inotify_add_watch(fd,path.c_str(),IN_CREATE|IN_MODIFY|IN_CLOSE_WRITE|IN_MOVED_TO|IN_DELETE|IN_MOVED_FROM|IN_DELETE_SELF|IN_MOVE_SELF) < 0) {
+
+			int err = errno;
+			close();
+
+			if(err == ENOENT && interval) {
+
+				// Directory not created yet (/run/<daemon> before the first start).
+				if(!retry.enabled()) {
+					clog << "Directory '" << path << "' not found, retrying every " << (interval / 1000) << " seconds" << endl;
+					retry.enable(interval);
 				}
 
+				return;
 			}
 
+			cerr << "Error '" << strerror(err) << "' watching '" << path << "', pidfile will not be watched" << endl;
+			retry.disable();
+			return;
 		}
 
+		if(retry.enabled()) {
+			retry.disable();
+		}
+
+		enable();
 
-		return Process::Agent::refresh();
 	}
 
- }
+	void Process::PidFileAgent::Watcher::handle_event(const Event UDJAT_UNUSED(event)) {
 
+		char buffer[sizeof(struct inotify_event) + NAME_MAX + 1] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+		bool changed = false;
+		bool lost = false;
+
+		ssize_t length;
+		while( (length = read(fd,buffer,sizeof(buffer))) > 0) {
+
+			for(char *ptr = buffer; ptr < buffer + length; ) {
+
+				const struct inotify_event *ev = (const struct inotify_event *) ptr;
+
+				if(ev->mask & (IN_DELETE_SELF|IN_MOVE_SELF|IN_IGNORED)) {
+					lost = true;
+				} else if(ev->len && !strcmp(ev->name,name)) {
+					changed = true;
+				}
+
+				ptr += sizeof(struct inotify_event) + ev->len;
+			}
+
+		}
+
+		if(length < 0 && errno != EAGAIN) {
+			cerr << "Error '" << strerror(errno) << "' reading inotify events" << endl;
+		}
+
+		if(lost) {
+
+			// The directory was removed or renamed (daemon stopped), the watch
+			// is gone; watch it again or go back to the retry timer.
+			close();
+			start();
+			load();
+			return;
+
+		}
+
+		if(changed) {
+			load();
+		}
+
+	}
+
+ }
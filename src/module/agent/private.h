@@ -21,6 +21,13 @@
  #include <udjat/defs.h>
  #include <udjat/process/agent.h>
  #include <udjat/agent/state.h>
+ #include <matcher.h>
+ #include <controller.h>
+ #include <udjat/tools/handler.h>
+ #include <string>
+ #include <unordered_set>
+ #include <mutex>
+ #include <chrono>
 
  using namespace std;
 
@@ -35,6 +42,11 @@
 
 			virtual bool test(const Process::Agent &agent) const noexcept = 0;
 
+			/// @brief Can the state change without a change on the process values?
+			virtual bool timed() const noexcept {
+				return false;
+			}
+
 		};
 
 		/// @brief Monitor process by exename
@@ -48,35 +60,240 @@
 			ExeNameAgent(const char *exename, const pugi::xml_node &node);
 
 			bool probe(const char *exename) const noexcept override;
+			bool index(Matcher &matcher) override;
 
 		};
 
-		/// @brief Monitor process by exename
+		/// @brief Monitor process by exename, command line or command name pattern.
+		/// @brief With an exename the pattern is tested only on processes running it.
+		class PatternAgent : public Process::Agent {
+		private:
+
+			/// @brief The process property to test.
+			Matcher::Field field;
+
+			/// @brief The pattern (shell wildcard).
+			const char *pattern;
+
+			/// @brief Required exename, nullptr for any.
+			const char *exename = nullptr;
+
+		public:
+			PatternAgent(Matcher::Field field, const char *pattern, const pugi::xml_node &node);
+			PatternAgent(Matcher::Field field, const char *pattern, const char *exename, const pugi::xml_node &node);
+
+			bool probe(const char *exename) const noexcept override;
+			bool probe(const Identifier &ident) const noexcept override;
+			bool index(Matcher &matcher) override;
+
+		};
+
+		/// @brief Monitor all the processes matching the agent selector.
+		template <class T>
+		class Aggregate : public T {
+		private:
+
+			/// @brief Protects instances and total; bind and unbind run on the
+			/// @brief controller, the getters also on the request threads.
+			mutable std::mutex guard;
+
+			/// @brief Bound processes.
+			std::unordered_set<Identifier *> instances;
+
+			/// @brief Totals from bound processes, summed again after bind, unbind and refresh.
+			mutable struct {
+				bool dirty = false;				///< @brief Need to sum the instances?
+				float cpu = 0;					///< @brief CPU usage in %.
+				unsigned long long rss = 0;		///< @brief Resident set size in bytes.
+			} total;
+
+			/// @brief Update the totals from the instances, if needed (guard locked).
+			void sum() const noexcept;
+
+			/// @brief Get the aggregated state (guard locked).
+			Process::Identifier::State state() const noexcept;
+
+		protected:
+			bool bind(Identifier *ident) override;
+			void unbind(Identifier *ident) override;
+			void changed(const Identifier &ident, float cpu, unsigned long long rss) override;
+
+		public:
+			template <typename... Args>
+			Aggregate(Args&&... args) : T(std::forward<Args>(args)...) {
+			}
+
+			void get(const Request &request, Response &response) override;
+
+			Process::Identifier::State getState() const noexcept override;
+			float getCPU() const noexcept override;
+			unsigned long long getRSS() const override;
+			unsigned long long getValue(Process::Agent::Field field) const override;
+
+		};
+
+		/// @brief Monitor process by pidfile
 		class PidFileAgent : public Process::Agent {
 		private:
 
 			/// @brief The pidfile to monitor.
 			const char *pidfile;
 
+			/// @brief Inotify watcher for the pidfile directory.
+			class Watcher : public MainLoop::Handler {
+			private:
+				PidFileAgent &agent;
+
+				/// @brief The pidfile name, without path.
+				const char *name;
+
+				/// @brief Retries the watch while the pidfile directory doesn't exist.
+				struct Retry : public MainLoop::Timer {
+
+					Watcher &watcher;
+
+					Retry(Watcher &w) : watcher(w) {
+					}
+
+					void on_timer() override;
+
+				} retry{*this};
+
+				/// @brief Load the pidfile, logging errors.
+				void load() noexcept;
+
+			protected:
+				void handle_event(const Event event) override;
+
+			public:
+				Watcher(PidFileAgent &agent);
+				~Watcher();
+
+				/// @brief Retry interval in milliseconds (attribute 'pidfile-retry', in seconds).
+				unsigned long interval = 10000;
+
+				/// @brief Start watching the pidfile directory, or retry later if it doesn't exist.
+				void start();
+
+			} watcher;
+
+			/// @brief The process bound from the pidfile, and the pidfile version it was read from.
+			struct {
+				pid_t pid = 0;
+				unsigned long long starttime = 0;
+				ino_t inode = 0;
+				struct timespec mtime = {0,0};
+			} identity;
+
+			/// @brief Read pid from pidfile and bind to it.
+			void load();
+
 		public:
 			PidFileAgent(const char *filename, const pugi::xml_node &node);
 
 			void start() override;
-			bool refresh() override;
 			bool probe(const char *exename) const noexcept override;
+			bool probe(const Identifier &ident) const noexcept override;
+			bool index(Matcher &matcher) override;
+
+		};
+
+		/// @brief The heaviest processes by CPU, RSS or block I/O delay.
+		class TopAgent : public Udjat::Agent<float> {
+		public:
+
+			/// @brief Resource types.
+			enum Resource : uint8_t {
+				CPU,	///< @brief CPU usage in %.
+				RSS,	///< @brief Resident set size in bytes.
+				IOWait	///< @brief Block I/O delay in clock ticks (needs delay accounting, see Identifier::getIOWait).
+			};
+
+			static const char * resourceNames[];
+
+		private:
+			std::mutex guard;
+
+			Resource resource;
+
+			/// @brief Number of processes to select ('top-count').
+			size_t count;
+
+			/// @brief Selected processes, storage allocated on construction.
+			std::vector<Process::Controller::Consumer> consumers;
+
+			/// @brief Exenames of the selected processes, storage allocated on construction.
+			struct Name {
+				pid_t pid = -1;
+				unsigned long long starttime = 0;
+				std::string exename;
+			};
 
+			std::vector<Name> names;
+
+			/// @brief Select the heaviest processes.
+			/// @return The value of the heaviest one.
+			float select();
+
+		public:
+			TopAgent(const char *resource, const pugi::xml_node &node);
+			bool refresh() override;
+			void start() override;
+			void get(const Request &request, Response &response) override;
+
+		};
+
+		/// @brief Controller self metrics, the value is the last refresh duration in ms.
+		class ControllerAgent : public Udjat::Agent<float> {
+		private:
+			std::mutex guard;
+
+			/// @brief Counters on the last agent refresh.
+			struct {
+				std::chrono::steady_clock::time_point time;
+				unsigned long long events[Controller::EventTypeCount];
+				unsigned long long locks = 0;
+				unsigned long long wait = 0;
+				unsigned long long hold = 0;
+				unsigned long long cpu = 0;		///< @brief Process CPU time in microseconds.
+			} last;
+
+			/// @brief Values computed on the last agent refresh.
+			struct {
+				float events[Controller::EventTypeCount];	///< @brief Events per second.
+				float locks = 0;							///< @brief Locks per second.
+				float wait = 0;								///< @brief Mean lock wait in microseconds.
+				float hold = 0;								///< @brief Mean lock hold in microseconds.
+				float cpu = 0;								///< @brief Process CPU usage in %.
+				unsigned long long rss = 0;					///< @brief Process resident set size in bytes.
+			} current;
+
+			/// @brief Update rates from the controller counters.
+			void sample();
+
+		public:
+			ControllerAgent(const pugi::xml_node &node);
+			bool refresh() override;
+			void start() override;
+			void get(const Request &request, Response &response) override;
 
 		};
 
-		/// @brief State counter
-		class StateCounterAgent : public Udjat::Agent<unsigned int> {
+		/// @brief Number of processes on a state, counted on the transitions.
+		class StateCounterAgent : public Udjat::Agent<unsigned int>, private Process::Subscriber {
 		private:
 			Process::Identifier::State state;
 
+			/// @brief Processes on the state.
+			std::atomic<unsigned int> counter{0};
+
+			void changed(const Identifier &identifier, Identifier::State from, Identifier::State to) override;
+
 		public:
 			StateCounterAgent(const char *statename, const pugi::xml_node &node);
 			bool refresh() override;
 			void start() override;
+			void stop() override;
 
 		};
 	}
@@ -20,6 +20,8 @@
  #include "private.h"
  #include <udjat/agent/state.h>
  #include <udjat/tools/logger.h>
+ #include <chrono>
+ #include <mutex>
 
  using Pid = Udjat::Process::Identifier;
 
@@ -63,20 +65,98 @@
 
 	};
 
-	/// @brief State by process usage in %
+	/// @brief State after a coredump on the bound process, until a new process is bound.
+	class ProcessCoredump : public Process::Agent::State {
+	public:
+		ProcessCoredump(const pugi::xml_node &node) : Process::Agent::State(node) {
+		}
+
+		bool test(const Process::Agent &agent) const noexcept override {
+			return agent.crashed();
+		}
+
+	};
+
+	/// @brief State by process CPU usage in %
+	/// @brief Activates after the usage stays in range for 'duration' seconds, and
+	/// @brief deactivates only when it leaves the range widened by 'hysteresis'.
 	class ProcessUsage : public Process::Agent::State {
 	protected:
 		float from, to;
 
+		/// @brief Range widening, in %, to leave the state once active.
+		float hysteresis;
+
+		/// @brief Time, in seconds, the usage must stay in range before activating.
+		std::chrono::seconds duration;
+
+		/// @brief Serializes the status, tested on the refresh and on requests.
+		mutable std::mutex guard;
+
+		mutable struct {
+			bool active = false;
+			bool pending = false;
+			std::chrono::steady_clock::time_point since;
+		} status;
+
 		bool compare(float value) const noexcept {
 			return value >= from && value <= to;
 		}
 
 	public:
-		ProcessUsage(const pugi::xml_node &node) : Process::Agent::State(node) {
+		ProcessUsage(const pugi::xml_node &node)
+			: Process::Agent::State(node),
+				hysteresis(node.attribute("hysteresis").as_float(0)),
+				duration(node.attribute("duration").as_uint(0)) {
 			XML::parse(node,from,to);
 		}
 
+		bool test(const Process::Agent &agent) const noexcept override {
+
+			// From the last refresh, no /proc reads.
+			float value = agent.getCPU();
+
+			std::lock_guard<std::mutex> lock(guard);
+
+			if(status.active) {
+
+				if(value >= (from - hysteresis) && value <= (to + hysteresis)) {
+					return true;
+				}
+
+				status.active = status.pending = false;
+				return false;
+
+			}
+
+			if(!compare(value)) {
+				status.pending = false;
+				return false;
+			}
+
+			auto now = std::chrono::steady_clock::now();
+
+			if(!status.pending) {
+				status.pending = true;
+				status.since = now;
+			}
+
+			if((now - status.since) >= duration) {
+				status.active = true;
+			}
+
+#ifdef DEBUG
+			agent.trace() << "CPU=" << value << " active=" << (status.active ? "yes" : "no") << endl;
+#endif // DEBUG
+
+			return status.active;
+
+		}
+
+		bool timed() const noexcept override {
+			return duration.count() > 0;
+		}
+
 	};
 
 	std::shared_ptr<Abstract::State> Process::Agent::StateFactory(const pugi::xml_node &node) {
@@ -95,6 +175,8 @@
 				state = make_shared<ProcessAvailable>(true,node);
 			} else if(strcasecmp(attr,"not-available") == 0) {
 				state = make_shared<ProcessAvailable>(false,node);
+			} else if(strcasecmp(attr,"coredump") == 0) {
+				state = make_shared<ProcessCoredump>(node);
 			} else {
 				state = make_shared<ProcessState>(attribute.as_string(),node);
 			}
@@ -105,6 +187,21 @@
 			}
 		}
 
+		// Agent state by CPU usage
+		attribute = node.attribute("process-usage");
+		if(attribute) {
+
+			if(strcasecmp(attribute.as_string(),"cpu")) {
+				throw system_error(EINVAL, system_category(),"Only 'cpu' is supported on process-usage");
+			}
+
+			state = make_shared<ProcessUsage>(node);
+			timed |= state->timed();
+			states.push_back(state);
+			return state;
+
+		}
+
 		attribute = node.attribute("field-name");
 		if(attribute) {
 			Process::Agent::Field field = Process::Agent::getField(attribute.as_string(Process::Agent::fieldNames[0]));
@@ -128,7 +225,52 @@
 
 			};
 
-			return make_shared<Value>(field, node);
+			state = make_shared<Value>(field, node);
+			states.push_back(state);
+			return state;
+
+		}
+
+		attribute = node.attribute("history");
+		if(attribute) {
+
+			/// @brief State based on a statistic from the agent history.
+			class Statistic : public Process::Agent::State {
+			private:
+				History::Metric metric;
+				History::Statistic statistic;
+				float percentile = 0;
+				float from = 0;
+				float to = 0;
+
+			public:
+				Statistic(History::Metric m, const pugi::xml_node &node) : Process::Agent::State(node), metric(m) {
+					statistic = History::StatisticFactory(node.attribute("statistic").as_string("mean"),percentile);
+					XML::parse(node,from,to);
+				}
+
+				bool test(const Process::Agent &agent) const noexcept override {
+
+					const History *history = agent.getHistory();
+					if(!history) {
+						return false;
+					}
+
+					float value = history->get(metric,statistic,percentile);
+					return value >= from && value <= to;
+				}
+
+				bool timed() const noexcept override {
+					// Old samples leave the window on every refresh.
+					return true;
+				}
+
+			};
+
+			state = make_shared<Statistic>(History::MetricFactory(attribute.as_string()), node);
+			timed = true;
+			states.push_back(state);
+			return state;
 
 		}
 
@@ -137,9 +279,21 @@
 
 	std::shared_ptr<Abstract::State> Process::Agent::computeState() {
 
+		// First match wins; the timed states after it are still tested to
+		// keep their windows on every sample.
+		std::shared_ptr<State> selected;
 		for(auto state : this->states) {
-			if(state->test(*this))
-				return state;
+			if(!selected) {
+				if(state->test(*this)) {
+					selected = state;
+				}
+			} else if(state->timed()) {
+				state->test(*this);
+			}
+		}
+
+		if(selected) {
+			return selected;
 		}
 
 		debug("Using default state");
@@ -0,0 +1,141 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ #include "private.h"
+ #include <udjat/tools/xml.h>
+ #include <unistd.h>
+ #include <limits.h>
+
+ namespace Udjat {
+
+	const char * Process::TopAgent::resourceNames[] = {
+		"cpu",
+		"rss",
+		"iowait"
+	};
+
+	static Process::TopAgent::Resource ResourceFactory(const char *name) {
+
+		for(size_t ix = 0; ix < N_ELEMENTS(Process::TopAgent::resourceNames); ix++) {
+
+			if(!strcasecmp(name,Process::TopAgent::resourceNames[ix])) {
+				return (Process::TopAgent::Resource) ix;
+			}
+
+		}
+
+		throw system_error(EINVAL, system_category(),"Invalid resource name");
+	}
+
+	Process::TopAgent::TopAgent(const char *r, const pugi::xml_node &node) : Udjat::Agent<float>(node), resource(ResourceFactory(r)), count(Attribute(node,"top-count").as_uint(5)) {
+
+		consumers.reserve(count);
+		names.resize(count);
+		for(auto &name : names) {
+			name.exename.reserve(PATH_MAX);
+		}
+
+	}
+
+	float Process::TopAgent::select() {
+
+		// Double keeps the byte and tick counts exact; a float rounds RSS above 16 MiB.
+		static double (* const values[])(const Identifier &ident) = {
+			[](const Identifier &ident) { return (double) ident.getCPU(); },
+			[](const Identifier &ident) { return (double) ident.getRSS(); },
+			[](const Identifier &ident) { return (double) ident.getIOWait(); },
+		};
+
+		lock_guard<mutex> lock(guard);
+
+		Process::Controller::getInstance().top(consumers,count,values[resource]);
+
+		// Resolve exenames, keep the ones already known.
+		for(size_t ix = 0; ix < consumers.size(); ix++) {
+
+			const auto &consumer = consumers[ix];
+			Name &name = names[ix];
+
+			if(name.pid == consumer.pid && name.starttime == consumer.starttime) {
+				continue;
+			}
+
+			char path[PATH_MAX];
+			char buffer[PATH_MAX];
+
+			snprintf(path,sizeof(path),"%s/%u/exe",Identifier::procfs(),(unsigned int) consumer.pid);
+			ssize_t sz = readlink(path,buffer,sizeof(buffer));
+
+			if(sz > 0) {
+				name.exename.assign(buffer,sz);
+			} else {
+				name.exename.clear();
+			}
+
+			name.pid = consumer.pid;
+			name.starttime = consumer.starttime;
+
+		}
+
+		return consumers.empty() ? 0 : (float) consumers.front().value;
+
+	}
+
+	void Process::TopAgent::start() {
+		super::start(select());
+	}
+
+	bool Process::TopAgent::refresh() {
+		return set(select());
+	}
+
+	void Process::TopAgent::get(const Request &request, Response &response) {
+
+		super::get(request,response);
+
+		lock_guard<mutex> lock(guard);
+
+		Value &top = response["top"];
+		for(size_t ix = 0; ix < consumers.size(); ix++) {
+
+			Value &item = top[std::to_string(ix+1).c_str()];
+
+			item["pid"] = (unsigned int) consumers[ix].pid;
+			item["exename"] = names[ix].exename.c_str();
+
+			switch(resource) {
+			case CPU:
+				item["cpu"].setFraction(consumers[ix].value / 100);
+				break;
+
+			case RSS:
+				item["rss"] = (unsigned long long) consumers[ix].value;
+				break;
+
+			case IOWait:
+				item["iowait"] = (unsigned long long) consumers[ix].value;
+				break;
+
+			}
+
+		}
+
+	}
+
+ }
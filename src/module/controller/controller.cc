@@ -36,84 +36,242 @@
 
  #include <config.h>
  #include <controller.h>
+ #include <tracepoints.h>
  #include <iostream>
  #include <unistd.h>
+ #include <algorithm>
 
  using namespace std;
 
  namespace Udjat {
 
-	std::recursive_mutex Process::Controller::guard;
+	Process::Controller::Guard Process::Controller::guard;
 
 	Process::Controller & Process::Controller::getInstance() {
-		lock_guard<recursive_mutex> lock(guard);
+		lock_guard<Guard> lock(guard);
 		static Controller instance;
 		return instance;
 	}
 
 	void Process::Controller::insert(Process::Agent *agent) {
-		lock_guard<recursive_mutex> lock(guard);
+		lock_guard<Guard> lock(guard);
 		agents.push_back(agent);
 
-		for(auto identifier = identifiers.begin(); identifier != identifiers.end(); identifier++) {
+		if(!agent->index(matcher)) {
+			unindexed.push_back(agent);
+		}
+
+		// Single process agents stop on the first match.
+		for(auto identifier = identifiers.begin(); identifier != identifiers.end() && !agent->pid; identifier++) {
 			if(agent->probe(*identifier)) {
-				agent->set(&(*identifier));
-				break;
+				bind(agent,*identifier);
 			}
 		}
 
 	}
 
 	void Process::Controller::remove(Process::Agent *agent) {
-		lock_guard<recursive_mutex> lock(guard);
+		lock_guard<Guard> lock(guard);
 		agents.remove_if([agent](Agent *a) {
 			return a == agent;
 		});
+		unindexed.remove(agent);
+		matcher.remove(agent);
+		pending.erase(std::remove(pending.begin(),pending.end(),agent),pending.end());
+		std::replace(batch.begin(),batch.end(),agent,(Agent *) nullptr);
+
+		// Being notified on the ThreadPool, wait for updated() to return.
+		if(notifier != this_thread::get_id()) {
+			while(current.load() == agent) {
+				this_thread::yield();
+			}
+		}
+
+		for(auto &identifier : identifiers) {
+			auto &bound = identifier.agents;
+			bound.erase(std::remove(bound.begin(),bound.end(),agent),bound.end());
+		}
+
+	}
+
+	bool Process::Controller::bind(Agent *agent, Identifier &identifier) {
+
+		lock_guard<Guard> lock(guard);
+
+		auto &bound = identifier.agents;
+		if(std::find(bound.begin(),bound.end(),agent) != bound.end()) {
+			return true;
+		}
+
+		if(!agent->bind(&identifier)) {
+			return false;
+		}
+
+		agent->signals.crashed = false;
+
+		PROCESS_PROBE2(bind,identifier.getPid(),agent->name());
+
+		bound.push_back(agent);
+
+		// A copy, callbacks can change the subscriptions.
+		auto subscribers = subscriptions.subscribers;
+		for(auto subscriber : subscribers) {
+			subscriber->bound(*agent,identifier);
+		}
+
+		return true;
+
+	}
+
+	void Process::Controller::unbind(Agent *agent, Identifier &identifier) {
+
+		lock_guard<Guard> lock(guard);
+
+		auto &bound = identifier.agents;
+		bound.erase(std::remove(bound.begin(),bound.end(),agent),bound.end());
+
+		PROCESS_PROBE2(unbind,identifier.getPid(),agent->name());
+
+		agent->unbind(&identifier);
+
+		// A copy, callbacks can change the subscriptions.
+		auto subscribers = subscriptions.subscribers;
+		for(auto subscriber : subscribers) {
+			subscriber->unbound(*agent,identifier);
+		}
+
+	}
+
+	void Process::Controller::set(Agent *agent, Identifier *identifier) {
+
+		lock_guard<Guard> lock(guard);
+
+		if(agent->pid == identifier) {
+			return;
+		}
+
+		if(agent->pid) {
+			unbind(agent,*agent->pid);
+		}
+
+		if(identifier) {
+			bind(agent,*identifier);
+		}
+
 	}
 
 	void Process::Controller::Controller::onInsert(Identifier &identifier) {
 
-		lock_guard<recursive_mutex> lock(guard);
+		// Process properties are read only when some pattern needs them.
+		Matcher::Subject subject{identifier};
+		onInsert(identifier,subject);
+
+	}
 
-		std::string exec = identifier.exename();
+	void Process::Controller::Controller::onInsert(Identifier &identifier, Matcher::Subject &subject) {
 
-//#ifdef DEBUG
-//		cout << "Adding process " << ((pid_t) identifier) << " - " << exec << " - " << agents.size() << endl;
-//#endif // DEBUG
+		lock_guard<Guard> lock(guard);
 
-		for(auto agent : agents) {
+		[[maybe_unused]] auto begin = probe_clock();
 
-			if(!agent->pid && agent->probe(exec.c_str())) {
-				agent->set(&identifier);
+		std::vector<Agent *> matches;
+		matcher.probe(subject,matches);
+
+		for(auto agent : unindexed) {
+			if(!agent->pid && agent->probe(subject[Matcher::ExeName].c_str())) {
+				matches.push_back(agent);
 			}
+		}
+
+		for(auto agent : matches) {
 
+			if(!agent->pid) {
+				bind(agent,identifier);
+			}
+
+		}
+
+		// Cached for the process table; usually loaded by the matcher or on startup.
+		// Replayed processes aren't on this system, their owner is unknown.
+		identifier.properties.exename = subject[Matcher::ExeName];
+		if(identifier.properties.uid == (uid_t) -1 && !player.reader) {
+			identifier.properties.uid = Identifier::uid(identifier.getPid());
 		}
 
+		PROCESS_PROBE2(insert,identifier.getPid(),probe_clock() - begin);
+
 	}
 
 	Process::Identifier * Process::Controller::find(const pid_t pid) {
 
-		lock_guard<recursive_mutex> lock(guard);
+		lock_guard<Guard> lock(guard);
+
+		Identifier *identifier = slots.find(pid);
 
-		for(auto it = identifiers.begin(); it != identifiers.end(); it++) {
+		if(identifier) {
 
-			if(it->getPid() == pid) {
-				return &(*it);
+			// Replayed processes aren't on this system, they're valid until the recording removes them.
+			if(player.reader || identifier->valid()) {
+				return identifier;
 			}
 
+			// Pid was reused, the EXIT event was lost.
+			remove(pid);
+
+		}
+
+		if(player.reader || !Identifier::StartTime(pid)) {
+			return nullptr;
 		}
 
-		return nullptr;
+		insert(pid);
+
+		return slots.find(pid);
 
 	}
 
 	void Process::Controller::Controller::insert(pid_t pid) noexcept {
 
-		lock_guard<recursive_mutex> lock(guard);
+		lock_guard<Guard> lock(guard);
+
+		if(player.reader) {
+			// Replaying, the processes come from the recording only.
+			return;
+		}
+
+		if(startup.tasks.load()) {
+			// Still populating, keep the initial load from adding it again.
+			startup.inserted.insert(pid);
+		}
 
 		try {
 
-			onInsert(identifiers.emplace_back(pid));
+			Identifier *known = slots.find(pid);
+
+			if(known) {
+
+				if(known->valid()) {
+					// Same process, new image; probe it again (a setuid image changes the owner).
+					known->properties.uid = (uid_t) -1;
+					onInsert(*known);
+					return;
+				}
+
+				// Pid was reused, the EXIT event was lost.
+				remove(pid);
+
+			}
+
+			Identifier &identifier = emplace(pid);
+
+			if(!identifier.getStartTime()) {
+				// Finished before its start time was read, nothing to track.
+				slots.release(identifier.slot);
+				identifiers.pop_back();
+				return;
+			}
+
+			onInsert(identifier);
 
 		} catch(const exception &e) {
 
@@ -126,7 +284,7 @@
 
 	size_t Process::Controller::count(const Process::Identifier::State state) {
 
-		lock_guard<recursive_mutex> lock(guard);
+		lock_guard<Guard> lock(guard);
 		size_t rc = 0;
 
 		for(auto identifier = identifiers.begin(); identifier != identifiers.end(); identifier++) {
@@ -140,25 +298,88 @@
 		return rc;
 	}
 
+	size_t Process::Controller::size() {
+		lock_guard<Guard> lock(guard);
+		return identifiers.size();
+	}
+
+	void Process::Controller::top(std::vector<Consumer> &consumers, size_t count, double (*value)(const Identifier &ident)) {
+
+		lock_guard<Guard> lock(guard);
+
+		// Bounded min-heap, the lighter of the selected processes on front.
+		auto heavier = [](const Consumer &a, const Consumer &b) {
+			return a.value > b.value;
+		};
+
+		consumers.clear();
+
+		if(!count) {
+			return;
+		}
+
+		for(auto &identifier : identifiers) {
+
+			double current = value(identifier);
+
+			if(current <= 0) {
+				continue;
+			}
+
+			if(consumers.size() < count) {
+
+				consumers.emplace_back();
+
+			} else if(current > consumers.front().value) {
+
+				pop_heap(consumers.begin(),consumers.end(),heavier);
+
+			} else {
+
+				continue;
+
+			}
+
+			Consumer &consumer = consumers.back();
+			consumer.pid = identifier.pid;
+			consumer.starttime = identifier.starttime;
+			consumer.value = current;
+
+			push_heap(consumers.begin(),consumers.end(),heavier);
+
+		}
+
+		sort_heap(consumers.begin(),consumers.end(),heavier);
+
+	}
+
 	void Process::Controller::Controller::remove(pid_t pid) noexcept {
 
 		try {
 
-			lock_guard<recursive_mutex> lock(guard);
+			lock_guard<Guard> lock(guard);
 
-			identifiers.remove_if([this,pid](Identifier &e) {
+			PROCESS_PROBE1(remove,pid);
 
-				if(e == pid) {
-					for(auto agent : agents) {
-						if(agent->pid == &e) {
-							agent->set( (Identifier *) nullptr);
-						}
-					}
-					return true;
-				}
-				return false;
+			Identifier *e = slots.find(pid);
+			if(!e) {
+				return;
+			}
+
+			while(!e->agents.empty()) {
+				unbind(e->agents.back(),*e);
+			}
+			if(slots.state[e->slot] != Identifier::Unknown && !subscriptions.transitions.empty()) {
+				transition(*e,slots.state[e->slot],Identifier::Undefined);
+			}
+
+			auto entry = slots.entry[e->slot];
+			slots.release(e->slot);
+			identifiers.erase(entry);
 
-			});
+			if(recorder) {
+				recorder->exited(pid);
+			}
 
 		} catch(const exception &e) {
 
@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ /**
+  * @brief Grace window for short lived processes.
+  *
+  * With [process] grace-window set, EXEC events are queued and the
+  * process is inserted only if still alive when the window expires;
+  * an EXIT inside the window cancels the EXEC and the process is never
+  * read from procfs. Tracked processes executing a new image are not
+  * deferred, they are probed again at once.
+  *
+  */
+
+ #include <config.h>
+ #include <controller.h>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	void Process::Controller::Deferred::on_timer() {
+		controller.expire();
+	}
+
+	void Process::Controller::defer(const pid_t pid) {
+
+		lock_guard<Guard> lock(guard);
+
+		if(slots.find(pid)) {
+			// Already tracked, a later EXIT must reach remove().
+			insert(pid);
+			return;
+		}
+
+		if(!deferred.waiting.insert(pid).second) {
+			return;
+		}
+
+		deferred.queue.emplace_back(pid,chrono::steady_clock::now() + chrono::milliseconds(deferred.window));
+
+		if(!deferred.enabled()) {
+			deferred.enable(deferred.window);
+		}
+
+	}
+
+	bool Process::Controller::cancel(const pid_t pid) {
+
+		lock_guard<Guard> lock(guard);
+
+		if(deferred.waiting.erase(pid)) {
+			metrics.coalesced.fetch_add(1,memory_order_relaxed);
+			return true;
+		}
+
+		return false;
+
+	}
+
+	void Process::Controller::expire() {
+
+		lock_guard<Guard> lock(guard);
+
+		auto now = chrono::steady_clock::now();
+
+		while(!deferred.queue.empty() && deferred.queue.front().second <= now) {
+
+			pid_t pid = deferred.queue.front().first;
+			deferred.queue.pop_front();
+
+			if(!deferred.waiting.erase(pid)) {
+				// Cancelled by EXIT.
+				continue;
+			}
+
+			if(Identifier::StartTime(pid)) {
+				insert(pid);
+			} else {
+				// Finished and the EXIT event was lost.
+				metrics.coalesced.fetch_add(1,memory_order_relaxed);
+			}
+
+		}
+
+		if(deferred.queue.empty() && deferred.enabled()) {
+			deferred.disable();
+		}
+
+	}
+
+ }
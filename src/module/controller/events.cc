@@ -0,0 +1,143 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ /**
+  * @brief Proc connector event queue.
+  *
+  * Events are queued by the netlink handler and processed on the
+  * ThreadPool; while queued, the events for the same pid are merged (the
+  * last one wins, EXEC+EXIT collapses into EXIT). Above [process]
+  * event-queue pending pids the queue is discarded and the process list
+  * is updated with a single reload().
+  *
+  * The discarded EXEC events are recovered on that reload by comparing the
+  * executable path of every process with the one read on insert: a
+  * readlink per process on each overload, instead of keeping an unbounded
+  * list of EXEC pids during the storm. An exec of the same executable
+  * (same path, new arguments) isn't detected, agents matching the command
+  * line keep the previous result until the process exits.
+  *
+  */
+
+ #include <config.h>
+ #include <controller.h>
+ #include <udjat/tools/threadpool.h>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	void Process::Controller::enqueue(const EventType type, const pid_t pid) {
+
+		lock_guard<mutex> lock(events.guard);
+
+		if(!events.overload) {
+
+			auto it = events.last.find(pid);
+			if(it == events.last.end()) {
+				events.last.emplace(pid,type);
+				events.order.push_back(pid);
+			} else {
+				it->second = type;
+				metrics.merged.fetch_add(1,memory_order_relaxed);
+			}
+
+			if(events.order.size() > events.limit) {
+				// Too many events, update from procfs instead.
+				events.overload = true;
+				events.order.clear();
+				events.last.clear();
+			}
+
+		}
+
+		if(!(events.scheduled || events.hold)) {
+			events.scheduled = true;
+			ThreadPool::getInstance().push([this]() {
+				dispatch();
+			});
+		}
+
+	}
+
+	void Process::Controller::dispatch() {
+
+		auto &order = events.work.order;
+		auto &last = events.work.last;
+
+		for(;;) {
+
+			bool overload;
+
+			{
+				lock_guard<mutex> lock(events.guard);
+
+				if(events.order.empty() && !events.overload) {
+					events.scheduled = false;
+					return;
+				}
+
+				order.swap(events.order);
+				last.swap(events.last);
+				overload = events.overload;
+				events.overload = false;
+			}
+
+			if(overload) {
+
+				metrics.overloads.fetch_add(1,memory_order_relaxed);
+				reload(true);
+
+			} else {
+
+				lock_guard<Guard> lock(guard);
+
+				for(auto pid : order) {
+
+					if(last[pid] == Exec) {
+
+						if(deferred.window) {
+							defer(pid);
+						} else {
+							insert(pid);
+						}
+
+					} else if(!cancel(pid)) {
+
+						remove(pid);
+
+					}
+
+				}
+
+				if(!deferred.queue.empty()) {
+					expire();
+				}
+
+			}
+
+			order.clear();
+			last.clear();
+
+		}
+
+	}
+
+ }
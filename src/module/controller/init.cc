@@ -36,6 +36,7 @@
 
  #include <config.h>
  #include <controller.h>
+ #include <tracepoints.h>
  #include <iostream>
  #include <unistd.h>
  #include <udjat/tools/mainloop.h>
@@ -76,16 +77,61 @@
 
 		Logger::trace() << "PID Watcher is starting" << endl;
 
-		// Load pids
+		// Get options.
+		Identifier::procfs();
+		update.cpu_use_per_process = Config::Value<bool>("cpu","get-by-pid",true);
+		update.cpu_delta = Config::Value<float>("cpu","notify-delta",1).get();
+		update.rss_delta = Config::Value<unsigned long long>("memory","notify-delta",1048576).get();
+		deferred.window = Config::Value<unsigned long>("process","grace-window",0).get();
+		events.limit = Config::Value<unsigned long>("process","event-queue",4096).get();
+
+		// Export the refresh values to local readers.
+		{
+			string path = Config::Value<string>("process","shared-memory","").get();
+			if(!path.empty()) {
+				try {
+					share(path.c_str(),Config::Value<unsigned int>("process","shared-memory-capacity",32768).get());
+				} catch(const exception &e) {
+					cerr << "Error '" << e.what() << "' exporting process list" << endl;
+				}
+			}
+		}
+
+		// Record the refresh values.
 		{
-			list<pid_t> pids;
-			load(pids);
+			string path = Config::Value<string>("process","recorder","").get();
+			if(!path.empty()) {
+				try {
+					recorder.reset(new Recording::Writer(
+						path.c_str(),
+						Config::Value<unsigned long long>("process","recorder-size",67108864ULL).get(),
+						Config::Value<unsigned int>("process","recorder-keyframe",60).get()
+					));
+				} catch(const exception &e) {
+					cerr << "Error '" << e.what() << "' opening process recorder" << endl;
+				}
+			}
+		}
 
-			for(auto pid : pids) {
-				onInsert(identifiers.emplace_back(pid));
+		// Replay a recording instead of watching the system.
+		{
+			string path = Config::Value<string>("process","replay","").get();
+			if(!path.empty()) {
+				try {
+					player.reader.reset(new Recording::Reader(path.c_str()));
+					Logger::trace() << "Replaying process recording " << path << endl;
+					recorder.reset();	// Nothing from this system to record.
+					MainLoop::Timer::enable(Config::Value<unsigned long>("cpu","update-timer",10000).get());
+					return;
+				} catch(const exception &e) {
+					cerr << "Error '" << e.what() << "' opening process recording" << endl;
+				}
 			}
 		}
 
+		// Queue the events until the initial population.
+		events.hold = true;
+
 		// Watch kernel process list.
 		// Create an endpoint for communication. Use the kernel user
 		// interface device (PF_NETLINK) which is a datagram oriented
@@ -115,7 +161,7 @@
 				my_nla.nl_groups = CN_IDX_PROC;
 				my_nla.nl_pid = getpid();
 
-				if(bind(fd, (struct sockaddr *)&my_nla, sizeof(my_nla)) < 0) {
+				if(::bind(fd, (struct sockaddr *)&my_nla, sizeof(my_nla)) < 0) {
 					throw std::system_error(errno, std::system_category(), "Can't bind process list connector");
 				}
 
@@ -159,17 +205,12 @@
 
 		}
 
-		// Get options.
-		update.cpu_use_per_process = Config::Value<bool>("cpu","get-by-pid",true);
+		// Load pids, the agents are bound as the processes are inserted.
+		populate(Config::Value<unsigned int>("process","startup-threads",0).get());
 
 		// Starting data colecting timer.
 		MainLoop::Timer::enable(Config::Value<unsigned long>("cpu","update-timer",10000).get());
 
-		// Do the first read.
-		ThreadPool::getInstance().push([this]() {
-			refresh();
-		});
-
 		// Load system usage.
 		{
 			System::Stat stat;
@@ -182,10 +223,18 @@
 	Process::Controller::~Controller() {
 		Logger::trace() << "PID watcher is stopping" << endl;
 		close();
+		unshare();
 	}
 
 	void Process::Controller::on_timer() {
 
+		if(player.reader) {
+			ThreadPool::getInstance().push([this]() {
+				play();
+			});
+			return;
+		}
+
 		if(fd < 0) {
 
 			// No kernel watcher, update from /proc.
@@ -237,17 +286,25 @@
 		if(recv_len < 1 || from_nla.nl_pid != 0)
 			return;
 
+		parse(buff,recv_len);
+
+	}
+
+	void Process::Controller::parse(const void *buffer, ssize_t length) {
+
 		// Read messages.
-		struct nlmsghdr		* nlh = (struct nlmsghdr*) buff;
+		struct nlmsghdr		* nlh = (struct nlmsghdr*) buffer;
 		struct proc_event	* ev;
 		struct cn_msg		* cn_hdr;
 
-		while (NLMSG_OK(nlh, recv_len)) {
+		while (NLMSG_OK(nlh, length)) {
 
 			cn_hdr = (struct cn_msg	*) NLMSG_DATA(nlh);
 
-			if (nlh->nlmsg_type == NLMSG_NOOP)
+			if (nlh->nlmsg_type == NLMSG_NOOP) {
+				nlh = NLMSG_NEXT(nlh, length);
 				continue;
+			}
 
 			if ((nlh->nlmsg_type == NLMSG_ERROR) || (nlh->nlmsg_type == NLMSG_OVERRUN))
 				break;
@@ -257,32 +314,45 @@
 			//
 			ev = (struct proc_event *) cn_hdr->data;
 
+			PROCESS_PROBE2(event,(unsigned int) ev->what,(pid_t) ev->event_data.exec.process_pid);
+
 			#pragma GCC diagnostic push
 			#pragma GCC diagnostic ignored "-Wswitch"
 			switch(ev->what) {
 			case proc_event::PROC_EVENT_EXEC:
+				metrics.events[Exec].fetch_add(1,memory_order_relaxed);
 				debug("Process '",((pid_t) ev->event_data.exec.process_pid),"' starts");
-				insert((pid_t) ev->event_data.exec.process_pid);
+				enqueue(Exec,(pid_t) ev->event_data.exec.process_pid);
 				break;
 
 			case proc_event::PROC_EVENT_EXIT:
+				metrics.events[Exit].fetch_add(1,memory_order_relaxed);
 				debug("Process '",((pid_t) ev->event_data.exec.process_pid),"' ends");
-				remove((pid_t) ev->event_data.exec.process_pid);
+				enqueue(Exit,(pid_t) ev->event_data.exec.process_pid);
 				break;
 
 #ifdef HAVE_PROC_EVENT_PTRACE
 			// http://lists.openwall.net/netdev/2011/07/12/105
 			case proc_event::PROC_EVENT_PTRACE:
-				debug("Ptrace detected on PID ",((pid_t),ev->event_data.id.process_pid));
+				metrics.events[Ptrace].fetch_add(1,memory_order_relaxed);
+				debug("Ptrace detected on PID ",((pid_t) ev->event_data.ptrace.process_tgid));
+				signal(Ptrace,(pid_t) ev->event_data.ptrace.process_tgid,(pid_t) ev->event_data.ptrace.tracer_tgid);
 				break;
 #endif // HAVE_PROC_EVENT_PTRACE
 
 #ifdef HAVE_PROC_EVENT_COREDUMP
 			case proc_event::PROC_EVENT_COREDUMP:
-				debug("Coredump detected on PID ",((pid_t) ev->event_data.id.process_pid));
+				// Not queued, the EXIT that follows would replace it.
+				metrics.events[Coredump].fetch_add(1,memory_order_relaxed);
+				debug("Coredump detected on PID ",((pid_t) ev->event_data.coredump.process_tgid));
+				signal(Coredump,(pid_t) ev->event_data.coredump.process_tgid);
 				break;
 #endif // HAVE_PROC_EVENT_COREDUMP
 
+			default:
+				metrics.events[Other].fetch_add(1,memory_order_relaxed);
+				break;
+
 /*
 			case proc_event::PROC_EVENT_FORK:
 				printf("fork: parent tid=%d pid=%d -> child tid=%d pid=%d\n",
@@ -325,7 +395,7 @@
 			if (nlh->nlmsg_type == NLMSG_DONE)
 				break;
 
-			nlh = NLMSG_NEXT(nlh, recv_len);
+			nlh = NLMSG_NEXT(nlh, length);
 		}
 
 	}
@@ -17,103 +17,146 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+
  #include <config.h>
  #include <controller.h>
+ #include <fcntl.h>
+ #include <unistd.h>
  #include <dirent.h>
- #include <sys/types.h> // for opendir(), readdir(), closedir()
+ #include <sys/syscall.h>
+ #include <algorithm>
  #include <iostream>
 
  using namespace std;
  namespace Udjat {
 
- 	bool isNumeric(const char *name) {
+	/// @brief Directory entry from getdents64(2).
+	struct linux_dirent64 {
+		ino64_t			d_ino;
+		off64_t			d_off;
+		unsigned short	d_reclen;
+		unsigned char	d_type;
+		char			d_name[];
+	};
 
-		while(*name) {
+	void Process::Controller::load(std::vector<pid_t> &entries) {
 
-			if(*name < '0' || *name > '9')
-				return false;
+		entries.clear(); // Just in case
 
-			name++;
+		if(entries.capacity() < 4096) {
+			entries.reserve(4096);
 		}
 
-		return true;
- 	}
+		metrics.read();
+		int fd = open(Identifier::procfs(),O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+		if(fd < 0) {
+			throw std::system_error(errno, std::system_category(), string{"Can't open "} + Identifier::procfs());
+		}
 
-	void Process::Controller::load(std::list<pid_t> &entries) {
+		// Read entries in large batches, parsing the pids inline.
+		alignas(linux_dirent64) char buffer[32768];
 
-		entries.clear(); // Just in case
+		for(;;) {
 
-		// https://stackoverflow.com/questions/939778/linux-api-to-list-running-processes
-		DIR *dir = opendir("/proc");
-		if(!dir) {
-			throw std::system_error(errno, std::system_category(), "Can't open /proc");
-		}
+			long length = syscall(SYS_getdents64,fd,buffer,sizeof(buffer));
 
-		struct dirent *entity;
-		while( (entity = readdir(dir))) {
-			if( !(entity->d_type == DT_DIR && isNumeric(entity->d_name)) )
-				continue;
-			entries.emplace_back( (pid_t) atoi(entity->d_name));
-		}
+			if(length < 0) {
+				int err = errno;
+				::close(fd);
+				throw std::system_error(err, std::system_category(), string{"Can't read "} + Identifier::procfs());
+			}
 
-		closedir(dir);
+			if(!length) {
+				break;
+			}
 
-#ifdef DEBUG
-		cout << "Loaded " << entries.size() << " entries from /proc" << endl;
-#endif // DEBUG
+			for(long offset = 0; offset < length;) {
 
-	}
+				const linux_dirent64 *entry = (const linux_dirent64 *) (buffer + offset);
+				offset += entry->d_reclen;
 
-	static bool search(const std::list<pid_t> &entries, const Process::Identifier &pid) {
+				if(entry->d_type != DT_DIR) {
+					continue;
+				}
 
-		for(auto e = entries.begin(); e != entries.end(); e++) {
-			if(*e == pid)
-				return true;
-		}
+				const char *name = entry->d_name;
+				if(*name < '1' || *name > '9') {
+					continue;
+				}
 
-		return false;
-	}
+				pid_t pid = 0;
+				while(*name >= '0' && *name <= '9') {
+					pid = (pid * 10) + (*name - '0');
+					name++;
+				}
 
-	static bool search(const std::list<Process::Identifier> &entries, const pid_t pid) {
+				if(!*name) {
+					entries.push_back(pid);
+				}
+
+			}
+
+		}
+
+		::close(fd);
 
-		for(auto e = entries.begin(); e != entries.end(); e++) {
-			if(*e == pid)
-				return true;
+		// procfs lists the pids in ascending order, but it's not guaranteed.
+		if(!is_sorted(entries.begin(),entries.end())) {
+			sort(entries.begin(),entries.end());
 		}
 
-		return false;
+#ifdef DEBUG
+		cout << "Loaded " << entries.size() << " entries from " << Identifier::procfs() << endl;
+#endif // DEBUG
+
 	}
 
-	void Process::Controller::reload() noexcept {
+	void Process::Controller::reload(bool reprobe) noexcept {
 
 		try {
 
-			// get updated list.
-			std::list<pid_t> current;
+			// get updated list; reloads are rare (overload or no kernel connector), plain locals.
+			std::vector<pid_t> current;
+			std::vector<pid_t> known;
+			std::vector<pid_t> finished;
+			std::vector<pid_t> changed;
+
 			load(current);
 
 			// Compare current list with the internal one.
 			{
-				lock_guard<recursive_mutex> lock(guard);
+				lock_guard<Guard> lock(guard);
 
 				// Remove finished processes.
-				this->identifiers.remove_if([current](Identifier &entry){
-					return !search(current,entry);
-				});
+				known.reserve(identifiers.size());
+				for(auto &entry : this->identifiers) {
+					pid_t pid = entry.getPid();
+					if(!binary_search(current.begin(),current.end(),pid)) {
+						finished.push_back(pid);
+					} else {
+						known.push_back(pid);
+						if(reprobe && entry.getExeName() != Identifier::exename(pid)) {
+							// Exec'd while the events were discarded.
+							changed.push_back(pid);
+						}
+					}
+				}
 
-				// Remove already registered identifiers.
-				current.remove_if([this](pid_t &entry){
-					return search(this->identifiers,entry);
-				});
+				for(auto pid : finished) {
+					remove(pid);
+				}
 
-				if(!current.empty()) {
+				// Same process, new image: insert() probes the agents again.
+				for(auto pid : changed) {
+					insert(pid);
+				}
 
-					// Add new processes to active list.
-					//this->entries.splice(this->entries.end(),current,current.begin(),current.end());
-					for(auto ix = current.begin(); ix != current.end(); ix++) {
-						insert(*ix);
+				// Add new processes to active list.
+				sort(known.begin(),known.end());
+				for(auto pid : current) {
+					if(!binary_search(known.begin(),known.end(),pid)) {
+						insert(pid);
 					}
-
 				}
 
 			}
@@ -121,10 +164,9 @@
 		} catch(const exception &e) {
 
 			cerr << "Error '" << e.what() << "' loading process list" << endl;
-			identifiers.clear();
+			clear();
 		}
 
 	}
 
  }
-
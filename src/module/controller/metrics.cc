@@ -0,0 +1,75 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ #include <config.h>
+ #include <controller.h>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	Process::Controller::Metrics Process::Controller::metrics;
+
+	thread_local unsigned int Process::Controller::Guard::depth = 0;
+	thread_local std::chrono::steady_clock::time_point Process::Controller::Guard::acquired;
+
+	const char * Process::Controller::eventTypeNames[] = {
+		"exec",
+		"exit",
+		"ptrace",
+		"coredump",
+		"other"
+	};
+
+	Process::Controller::Metrics::Metrics() {
+		for(auto &event : events) {
+			event = 0;
+		}
+	}
+
+	void Process::Controller::Guard::lock() {
+
+		if(depth) {
+			mutex.lock();
+			depth++;
+			return;
+		}
+
+		auto begin = chrono::steady_clock::now();
+		mutex.lock();
+		acquired = chrono::steady_clock::now();
+		depth = 1;
+
+		metrics.lock.wait.fetch_add(chrono::duration_cast<chrono::nanoseconds>(acquired - begin).count(),memory_order_relaxed);
+
+	}
+
+	void Process::Controller::Guard::unlock() {
+
+		if(!--depth) {
+			metrics.lock.hold.fetch_add(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - acquired).count(),memory_order_relaxed);
+			metrics.lock.count.fetch_add(1,memory_order_relaxed);
+		}
+
+		mutex.unlock();
+
+	}
+
+ }
@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ #include <config.h>
+ #include <pool.h>
+ #include <new>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	/// @brief Block alignment.
+	static constexpr size_t alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+	void Pool::grow() {
+
+		slabs.emplace_back(new char[size * blocks]);
+
+		// Link the new blocks, the first one at the head.
+		char *slab = slabs.back().get();
+		for(size_t ix = blocks; ix > 0; ix--) {
+			void *block = slab + ((ix-1) * size);
+			*((void **) block) = available;
+			available = block;
+		}
+
+		counters.capacity.fetch_add(blocks,memory_order_relaxed);
+
+	}
+
+	void * Pool::allocate(size_t sz) {
+
+		if(!size) {
+			size = ((max(sz,sizeof(void *)) + alignment - 1) / alignment) * alignment;
+		}
+
+		if(sz > size) {
+			// Not a pool block.
+			return ::operator new(sz);
+		}
+
+		if(!available) {
+			grow();
+		}
+
+		void *block = available;
+		available = *((void **) block);
+
+		size_t used = counters.used.fetch_add(1,memory_order_relaxed) + 1;
+		if(used > counters.high.load(memory_order_relaxed)) {
+			counters.high.store(used,memory_order_relaxed);
+		}
+
+		return block;
+
+	}
+
+	void Pool::deallocate(void *ptr, size_t sz) noexcept {
+
+		if(sz > size) {
+			::operator delete(ptr);
+			return;
+		}
+
+		*((void **) ptr) = available;
+		available = ptr;
+
+		counters.used.fetch_sub(1,memory_order_relaxed);
+
+	}
+
+ }
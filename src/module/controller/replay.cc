@@ -0,0 +1,260 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ /**
+  * @brief Refresh recorder and replay.
+  *
+  * With [process] recorder set every refresh is appended to a ring file
+  * (see recorder.h); with [process] replay set the controller does not
+  * watch the system, each timer cycle applies the next recorded
+  * generation to the identifiers and runs the same agent evaluation as a
+  * refresh.
+  *
+  */
+
+ #include <config.h>
+ #include <controller.h>
+ #include <tracepoints.h>
+ #include <udjat/tools/logger.h>
+ #include <algorithm>
+ #include <iostream>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	void Process::Controller::record() noexcept {
+
+		lock_guard<mutex> lock(recording.guard);
+
+		auto &entries = recording.entries;
+		entries.clear();
+
+		uint64_t number;
+		unsigned long long running, idle;
+
+		{
+			lock_guard<Guard> lock(guard);
+
+			number = metrics.refreshes.load(memory_order_relaxed);
+			running = system.running;
+			idle = system.idle;
+
+			for(size_t slot = 0; slot < slots.size(); slot++) {
+
+				const Identifier *identifier = slots.owner[slot];
+
+				if(!identifier) {
+					continue;
+				}
+
+				entries.emplace_back();
+
+				Recording::Writer::Entry &entry = entries.back();
+				entry.sample = Recording::Sample{slots.pid[slot],slots.state[slot],slots.ticks[slot],identifier->getRSS(),identifier->getVSize()};
+				entry.starttime = identifier->getStartTime();
+
+				// Only the new processes are stored with their names.
+				if(!recorder->known(entry.sample.pid,entry.starttime)) {
+					entry.exename = identifier->getExeName();
+				}
+
+			}
+
+		}
+
+		// Reads procfs for the new processes, the controller is free meanwhile.
+		try {
+
+			recorder->write(number,running,idle,entries);
+
+		} catch(const exception &e) {
+
+			cerr << "Error '" << e.what() << "' recording process list" << endl;
+
+		}
+
+	}
+
+	void Process::Controller::replay(const Recording::Generation &generation) {
+
+		lock_guard<Guard> lock(guard);
+
+		auto begin = chrono::steady_clock::now();
+
+		PROCESS_PROBE1(refresh_start,identifiers.size());
+
+		auto &index = work.index;
+		auto &stale = work.stale;
+
+		index.clear();
+		stale.clear();
+
+		for(size_t slot = 0; slot < slots.size(); slot++) {
+			if(slots.owner[slot]) {
+				index[slots.pid[slot]] = slots.owner[slot];
+			}
+		}
+
+		// A key frame has the full process list.
+		if(generation.key) {
+
+			for(auto &entry : index) {
+
+				auto spawn = lower_bound(generation.spawned.begin(),generation.spawned.end(),entry.first,[](const Recording::Spawn &spawn, pid_t pid){
+					return spawn.pid < pid;
+				});
+
+				if(spawn == generation.spawned.end() || spawn->pid != entry.first) {
+					stale.push_back(entry.first);
+				}
+
+			}
+
+		}
+
+		stale.insert(stale.end(),generation.removed.begin(),generation.removed.end());
+
+		for(auto pid : stale) {
+			remove(pid);
+			index.erase(pid);
+		}
+
+		for(auto &spawn : generation.spawned) {
+
+			auto it = index.find(spawn.pid);
+
+			if(it != index.end()) {
+
+				if(it->second->getStartTime() == spawn.starttime) {
+					continue;
+				}
+
+				remove(spawn.pid);
+
+			}
+
+			Identifier &identifier = emplace(spawn.pid,spawn.starttime);
+
+			Matcher::Subject subject{identifier};
+			for(size_t field = 0; field < Matcher::FieldCount; field++) {
+				subject.set((Matcher::Field) field,string{spawn.values[field]});
+			}
+
+			onInsert(identifier,subject);
+			index[spawn.pid] = &identifier;
+
+		}
+
+		// System usage.
+		float sysusage = 0;
+
+		if((system.running || system.idle) && generation.running >= system.running && generation.idle >= system.idle) {
+
+			float running = (float) (generation.running - system.running);
+			float idle = (float) (generation.idle - system.idle);
+			if(running + idle > 0) {
+				sysusage = this->system.cpu = (running / (running+idle));
+			}
+
+		}
+
+		system.running = generation.running;
+		system.idle = generation.idle;
+
+		// Process values, the unchanged ones have no delta.
+		auto &bound = work.bound;
+		bound.clear();
+
+		std::fill(slots.delta.begin(),slots.delta.end(),0);
+
+		float totaltime = 0;
+		for(auto &sample : generation.changed) {
+
+			auto it = index.find(sample.pid);
+			if(it == index.end()) {
+				continue;
+			}
+
+			Identifier &info = *it->second;
+			uint32_t slot = info.slot;
+
+			if(!info.agents.empty()) {
+				bound.push_back(Bound{&info,info.getCPU(),info.rss,sample.state != slots.state[slot]});
+			}
+
+			if(sample.state != slots.state[slot] && !subscriptions.transitions.empty()) {
+				transition(info,slots.state[slot],sample.state);
+			}
+
+			slots.state[slot] = sample.state;
+			info.set(sample.state);
+			info.rss = sample.rss;
+			info.vsize = sample.vsize;
+
+			if(sample.ticks && slots.ticks[slot] && sample.ticks > slots.ticks[slot]) {
+				slots.delta[slot] = (float) (sample.ticks - slots.ticks[slot]);
+				totaltime += slots.delta[slot];
+			}
+
+			slots.ticks[slot] = sample.ticks;
+
+		}
+
+		evaluate(sysusage,totaltime);
+
+		if(shared.header) {
+			publish(sysusage);
+		}
+
+		sample();
+
+		metrics.refreshes.fetch_add(1,memory_order_relaxed);
+		metrics.duration.store(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - begin).count(),memory_order_relaxed);
+
+		PROCESS_PROBE2(refresh_end,metrics.duration.load(memory_order_relaxed),identifiers.size());
+
+	}
+
+	bool Process::Controller::play() noexcept {
+
+		lock_guard<Guard> lock(guard);
+
+		try {
+
+			if(player.reader->read(player.generation)) {
+				replay(player.generation);
+				return true;
+			}
+
+			Logger::trace() << "End of the process recording" << endl;
+
+		} catch(const exception &e) {
+
+			cerr << "Error '" << e.what() << "' replaying process recording" << endl;
+
+		}
+
+		MainLoop::Timer::disable();
+		return false;
+
+	}
+
+ }
@@ -0,0 +1,192 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ /**
+  * @brief Shared memory export of the refresh values.
+  *
+  * With [process] shared-memory set to a path (usually on /dev/shm) every
+  * refresh is written to a mapped file with the layout from
+  * udjat/process/shared.h; local tools read it without syscalls or locks
+  * and retry when the seqlock changes under them.
+  *
+  */
+
+ #include <config.h>
+ #include <controller.h>
+ #include <udjat/tools/logger.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <chrono>
+ #include <cstring>
+ #include <cstdlib>
+ #include <cstdio>
+ #include <system_error>
+ #include <iostream>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	void Process::Controller::share(const char *path, uint32_t capacity) {
+
+		lock_guard<Guard> lock(guard);
+
+		unshare();
+
+		// Built on a new file and renamed into place: the export directory is
+		// usually world writable (/dev/shm) and an existing path, or a symlink
+		// planted on it, must never be opened, followed or truncated.
+		string temp{path};
+		temp += ".XXXXXX";
+
+		int fd = mkostemp((char *) temp.data(),O_CLOEXEC);
+		if(fd < 0) {
+			throw system_error(errno,system_category(),path);
+		}
+
+		size_t length = sizeof(Shared::Header) + (capacity * sizeof(Shared::Record));
+
+		auto fail = [&](int err) {
+			::close(fd);
+			unlink(temp.c_str());
+			throw system_error(err,system_category(),path);
+		};
+
+		struct stat st;
+		if(fstat(fd,&st)) {
+			fail(errno);
+		}
+
+		if(!S_ISREG(st.st_mode) || st.st_uid != geteuid()) {
+			fail(EPERM);
+		}
+
+		if(fchmod(fd,0644) || ftruncate(fd,length)) {
+			fail(errno);
+		}
+
+		void *ptr = mmap(nullptr,length,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+		if(ptr == MAP_FAILED) {
+			fail(errno);
+		}
+
+		::close(fd);
+
+		Shared::Header *header = (Shared::Header *) ptr;
+
+		header->version = Shared::Version;
+		header->header = sizeof(Shared::Header);
+		header->record = sizeof(Shared::Record);
+		header->capacity = capacity;
+		header->sequence.store(0,memory_order_relaxed);
+
+		// Magic is the last field set, readers check it before anything else.
+		atomic_thread_fence(memory_order_release);
+		header->magic = Shared::Magic;
+
+		// Replaces the path itself, never what a symlink on it points to.
+		if(rename(temp.c_str(),path)) {
+			int err = errno;
+			munmap(ptr,length);
+			unlink(temp.c_str());
+			throw system_error(err,system_category(),path);
+		}
+
+		shared.path = path;
+		shared.header = header;
+		shared.length = length;
+
+		Logger::trace() << "Exporting up to " << capacity << " processes on " << path << endl;
+
+	}
+
+	void Process::Controller::unshare() noexcept {
+
+		lock_guard<Guard> lock(guard);
+
+		if(!shared.header) {
+			return;
+		}
+
+		munmap(shared.header,shared.length);
+
+		if(unlink(shared.path.c_str())) {
+			cerr << "Error '" << strerror(errno) << "' removing " << shared.path << endl;
+		}
+
+		shared.header = nullptr;
+		shared.length = 0;
+		shared.path.clear();
+
+	}
+
+	void Process::Controller::publish(float cpu) noexcept {
+
+		lock_guard<Guard> lock(guard);
+
+		Shared::Header &header = *shared.header;
+		Shared::Record *records = (Shared::Record *) (shared.header + 1);
+
+		// Odd sequence: update in progress.
+		uint64_t sequence = header.sequence.load(memory_order_relaxed);
+		header.sequence.store(sequence+1,memory_order_relaxed);
+		atomic_thread_fence(memory_order_release);
+
+		uint32_t count = 0;
+		uint32_t total = 0;
+
+		for(size_t slot = 0; slot < slots.size(); slot++) {
+
+			const Identifier *identifier = slots.owner[slot];
+
+			if(!identifier) {
+				continue;
+			}
+
+			total++;
+
+			if(count < header.capacity) {
+
+				Shared::Record &record = records[count++];
+
+				record.pid = slots.pid[slot];
+				record.state = (uint8_t) slots.state[slot];
+				record.cpu = identifier->getCPU();
+				record.starttime = identifier->getStartTime();
+				record.rss = identifier->getRSS();
+				record.vsize = identifier->getVSize();
+
+			}
+
+		}
+
+		header.count = count;
+		header.total = total;
+		header.cpu = cpu * 100;
+		header.generation = metrics.refreshes.load(memory_order_relaxed) + 1;
+		header.timestamp = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+
+		header.sequence.store(sequence+2,memory_order_release);
+
+	}
+
+ }
@@ -0,0 +1,78 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ /**
+  * @brief Kernel signals from the proc connector.
+  *
+  * Coredump and ptrace events are delivered to the bound agents as soon as
+  * they arrive, not queued: a coredump is always followed by the EXIT of
+  * the same process, which would replace it on the event queue.
+  *
+  */
+
+ #include <config.h>
+ #include <controller.h>
+ #include <iostream>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	void Process::Controller::signal(const EventType type, const pid_t pid, const pid_t tracer) noexcept {
+
+		lock_guard<Guard> lock(guard);
+
+		// Tracked processes only, no procfs reads: the process may be already gone.
+		for(auto &identifier : identifiers) {
+
+			if(identifier.getPid() != pid) {
+				continue;
+			}
+
+			for(auto agent : identifier.agents) {
+
+				try {
+
+					if(type == Coredump) {
+						agent->coredump(identifier);
+					} else {
+						agent->ptrace(identifier,tracer);
+					}
+
+				} catch(const std::exception &e) {
+
+					cerr << "Error '" << e.what() << "' signaling pid " << pid << endl;
+
+				}
+
+				notify(agent);
+
+			}
+
+			break;
+
+		}
+
+		// Update the agent states now, not on the next refresh.
+		flush();
+
+	}
+
+ }
@@ -0,0 +1,145 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ #include <config.h>
+ #include <controller.h>
+ #include <iostream>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	uint32_t Process::Controller::Slots::allocate(Identifiers::iterator entry) {
+
+		Identifier &identifier = *entry;
+
+		uint32_t slot;
+
+		if(available.empty()) {
+
+			slot = (uint32_t) owner.size();
+
+			owner.push_back(nullptr);
+			pid.push_back(0);
+			ticks.push_back(0);
+			delta.push_back(0);
+			percent.push_back(0);
+			state.push_back(Identifier::Unknown);
+			this->entry.push_back(entry);
+
+		} else {
+
+			slot = available.back();
+			available.pop_back();
+
+		}
+
+		owner[slot] = &identifier;
+		pid[slot] = identifier.getPid();
+		ticks[slot] = 0;
+		delta[slot] = 0;
+		percent[slot] = 0;
+		state[slot] = Identifier::Unknown;
+		this->entry[slot] = entry;
+
+		index[identifier.getPid()] = slot;
+
+		return slot;
+
+	}
+
+	void Process::Controller::Slots::release(uint32_t slot) noexcept {
+
+		auto it = index.find(pid[slot]);
+		if(it != index.end() && it->second == slot) {
+			index.erase(it);
+		}
+
+		owner[slot] = nullptr;
+		pid[slot] = 0;
+		delta[slot] = 0;
+		percent[slot] = 0;
+
+		available.push_back(slot);
+
+	}
+
+	Process::Identifier * Process::Controller::Slots::find(pid_t pid) const noexcept {
+
+		auto it = index.find(pid);
+		if(it == index.end()) {
+			return nullptr;
+		}
+
+		return owner[it->second];
+
+	}
+
+	void Process::Controller::Slots::clear() noexcept {
+		owner.clear();
+		pid.clear();
+		ticks.clear();
+		delta.clear();
+		percent.clear();
+		state.clear();
+		entry.clear();
+		available.clear();
+		index.clear();
+	}
+
+	Process::Identifier & Process::Controller::emplace(pid_t pid) {
+
+		lock_guard<Guard> lock(guard);
+
+		Identifier &identifier = identifiers.emplace_back(pid);
+		identifier.slot = slots.allocate(std::prev(identifiers.end()));
+		return identifier;
+
+	}
+
+	Process::Identifier & Process::Controller::emplace(pid_t pid, unsigned long long starttime) {
+
+		lock_guard<Guard> lock(guard);
+
+		Identifier &identifier = identifiers.emplace_back(pid,starttime);
+		identifier.slot = slots.allocate(std::prev(identifiers.end()));
+		return identifier;
+
+	}
+
+	void Process::Controller::clear() noexcept {
+
+		lock_guard<Guard> lock(guard);
+
+		for(auto &identifier : identifiers) {
+			while(!identifier.agents.empty()) {
+				unbind(identifier.agents.back(),identifier);
+			}
+			if(slots.state[identifier.slot] != Identifier::Unknown && !subscriptions.transitions.empty()) {
+				transition(identifier,slots.state[identifier.slot],Identifier::Undefined);
+			}
+		}
+
+		identifiers.clear();
+		slots.clear();
+
+	}
+
+ }
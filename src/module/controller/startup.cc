@@ -0,0 +1,170 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ /**
+  * @brief Initial process list.
+  *
+  * The controller subscribes to the proc connector before reading procfs;
+  * events arriving meanwhile are queued and dispatched only after the
+  * initial population. The pid list is split in ranges loaded in parallel
+  * on the ThreadPool: start time and exename are read without the
+  * controller lock, agents are bound as each process is inserted.
+  *
+  */
+
+ #include <config.h>
+ #include <controller.h>
+ #include <udjat/tools/threadpool.h>
+ #include <udjat/tools/logger.h>
+ #include <algorithm>
+ #include <iostream>
+ #include <memory>
+ #include <thread>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	void Process::Controller::populate(size_t threads) {
+
+		{
+			lock_guard<mutex> lock(events.guard);
+			events.hold = true;
+		}
+
+		auto pids = make_shared<vector<pid_t>>();
+
+		try {
+
+			load(*pids);
+
+		} catch(const exception &e) {
+
+			cerr << "Error '" << e.what() << "' loading process list" << endl;
+			pids->clear();
+
+		}
+
+		if(!threads) {
+			threads = std::max(1U,std::thread::hardware_concurrency());
+		}
+
+		// Small ranges are not worth a task.
+		size_t length = std::max((size_t) 256, (pids->size() + threads - 1) / threads);
+
+		if(pids->empty()) {
+			populated();
+			return;
+		}
+
+		startup.tasks = (pids->size() + length - 1) / length;
+
+		for(size_t from = 0; from < pids->size(); from += length) {
+
+			size_t to = std::min(from + length, pids->size());
+
+			ThreadPool::getInstance().push([this,pids,from,to]() {
+
+				populate(*pids,from,to);
+
+				if(startup.tasks.fetch_sub(1) == 1) {
+					populated();
+				}
+
+			});
+
+		}
+
+	}
+
+	void Process::Controller::populate(const std::vector<pid_t> &pids, size_t from, size_t to) noexcept {
+
+		for(size_t ix = from; ix < to; ix++) {
+
+			pid_t pid = pids[ix];
+
+			try {
+
+				unsigned long long starttime = Identifier::StartTime(pid);
+				if(!starttime) {
+					// Finished before we got to it.
+					continue;
+				}
+
+				string exename = Identifier::exename(pid);
+				uid_t uid = Identifier::uid(pid);
+
+				lock_guard<Guard> lock(guard);
+
+				if(startup.inserted.count(pid)) {
+					continue;
+				}
+
+				Identifier &identifier = emplace(pid,starttime);
+				identifier.properties.uid = uid;
+
+				Matcher::Subject subject{identifier};
+				subject.set(Matcher::ExeName,std::move(exename));
+				onInsert(identifier,subject);
+
+			} catch(const exception &e) {
+
+				cerr << "Error '" << e.what() << "' inserting pid " << pid << endl;
+
+			}
+
+		}
+
+	}
+
+	void Process::Controller::populated() noexcept {
+
+		size_t count;
+
+		{
+			lock_guard<Guard> lock(guard);
+			startup.inserted.clear();
+			count = identifiers.size();
+		}
+
+		Logger::trace() << "Process list loaded with " << count << " identifiers" << endl;
+
+		{
+			lock_guard<mutex> lock(events.guard);
+
+			events.hold = false;
+
+			if(!events.scheduled && (events.overload || !events.order.empty())) {
+				events.scheduled = true;
+				ThreadPool::getInstance().push([this]() {
+					dispatch();
+				});
+			}
+
+		}
+
+		// Do the first read.
+		ThreadPool::getInstance().push([this]() {
+			refresh();
+		});
+
+	}
+
+ }
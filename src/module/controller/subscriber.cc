@@ -0,0 +1,137 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ /**
+  * @brief Process transition subscriptions.
+  *
+  * The controller calls the subscribers as soon as it detects a change:
+  * state transitions on the refresh (or replay), new processes on their
+  * first refresh, removed ones on the EXIT event, and agent bind/unbind.
+  *
+  */
+
+ #include <config.h>
+ #include <controller.h>
+ #include <algorithm>
+ #include <iostream>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	Process::Subscriber::~Subscriber() {
+		unsubscribe();
+	}
+
+	void Process::Subscriber::subscribe(Identifier::State from, Identifier::State to) {
+
+		Controller &controller = Controller::getInstance();
+		lock_guard<Controller::Guard> lock(Controller::guard);
+
+		auto &subscribers = controller.subscriptions.subscribers;
+		if(std::find(subscribers.begin(),subscribers.end(),this) == subscribers.end()) {
+			subscribers.push_back(this);
+		}
+
+		controller.subscriptions.transitions.push_back({this,from,to});
+		subscribed = true;
+
+	}
+
+	void Process::Subscriber::unsubscribe() noexcept {
+
+		if(!subscribed) {
+			// Never subscribed, don't build the controller just for this.
+			return;
+		}
+
+		Controller &controller = Controller::getInstance();
+		lock_guard<Controller::Guard> lock(Controller::guard);
+
+		auto &subscribers = controller.subscriptions.subscribers;
+		subscribers.erase(std::remove(subscribers.begin(),subscribers.end(),this),subscribers.end());
+
+		auto &transitions = controller.subscriptions.transitions;
+		transitions.erase(std::remove_if(transitions.begin(),transitions.end(),[this](const Controller::Subscription &subscription){
+			return subscription.subscriber == this;
+		}),transitions.end());
+
+		subscribed = false;
+
+	}
+
+	void Process::Subscriber::changed(const Identifier UDJAT_UNUSED(&identifier), Identifier::State UDJAT_UNUSED(from), Identifier::State UDJAT_UNUSED(to)) {
+	}
+
+	void Process::Subscriber::bound(const Agent UDJAT_UNUSED(&agent), const Identifier UDJAT_UNUSED(&identifier)) {
+	}
+
+	void Process::Subscriber::unbound(const Agent UDJAT_UNUSED(&agent), const Identifier UDJAT_UNUSED(&identifier)) {
+	}
+
+	size_t Process::Controller::count(const Process::Identifier::State state, Subscriber *subscriber) {
+
+		lock_guard<Guard> lock(guard);
+
+		subscriber->subscribe(state,Identifier::Undefined);
+		subscriber->subscribe(Identifier::Undefined,state);
+
+		size_t rc = 0;
+		for(size_t slot = 0; slot < slots.size(); slot++) {
+			if(slots.owner[slot] && slots.state[slot] == state) {
+				rc++;
+			}
+		}
+
+		return rc;
+
+	}
+
+	void Process::Controller::transition(const Identifier &identifier, Identifier::State from, Identifier::State to) noexcept {
+
+		lock_guard<Guard> lock(guard);
+
+		if(from == Identifier::Unknown) {
+			from = Identifier::Undefined;
+		}
+
+		// A copy, callbacks can change the subscriptions.
+		auto transitions = subscriptions.transitions;
+		for(auto &subscription : transitions) {
+
+			if((subscription.from == Identifier::Undefined || subscription.from == from) && (subscription.to == Identifier::Undefined || subscription.to == to)) {
+
+				try {
+
+					subscription.subscriber->changed(identifier,from,to);
+
+				} catch(const exception &e) {
+
+					cerr << "Error '" << e.what() << "' notifying state transition of pid " << identifier.getPid() << endl;
+
+				}
+
+			}
+
+		}
+
+	}
+
+ }
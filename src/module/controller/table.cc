@@ -0,0 +1,190 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ /**
+  * @brief Process table request.
+  *
+  * The table is copied from the identifiers in a single pass under the
+  * controller lock, exename and uid included (cached on insert), so a
+  * request never reads procfs; the filters run on the copy and only the
+  * requested page is sorted.
+  *
+  */
+
+ #include <config.h>
+ #include <controller.h>
+ #include <fnmatch.h>
+ #include <unistd.h>
+ #include <climits>
+ #include <algorithm>
+ #include <cctype>
+ #include <cerrno>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	/// @brief Process values on the snapshot.
+	struct Row {
+		pid_t pid;
+		Process::Identifier::State state;
+		float cpu;
+		unsigned long long rss;
+		unsigned long long vsize;
+		uid_t uid;
+		std::string exename;
+	};
+
+	/// @brief Parse a numeric request argument.
+	static unsigned long number(const string &value, const char *name) {
+
+		char *end = nullptr;
+		errno = 0;
+		unsigned long rc = strtoul(value.c_str(),&end,10);
+
+		if(value.empty() || !isdigit(value[0]) || *end || errno) {
+			throw system_error(EINVAL, system_category(),string{"Invalid "} + name);
+		}
+
+		return rc;
+
+	}
+
+	void Process::Controller::get(const Request &request, Response &response) {
+
+		static const char * sortNames[] = { "pid", "cpu", "rss" };
+
+		// Arguments.
+		string state = request.getArgument("state");
+		string exename = request.getArgument("exename");
+		string uid = request.getArgument("uid");
+		string sort = request.getArgument("sort","pid");
+		size_t offset = (size_t) number(request.getArgument("offset","0"),"offset");
+		size_t limit = (size_t) number(request.getArgument("limit","100"),"limit");
+		uid_t owner = uid.empty() ? (uid_t) -1 : (uid_t) number(uid,"uid");
+
+		size_t key = 0;
+		while(key < N_ELEMENTS(sortNames) && strcasecmp(sort.c_str(),sortNames[key])) {
+			key++;
+		}
+
+		if(key == N_ELEMENTS(sortNames)) {
+			throw system_error(EINVAL, system_category(),"Invalid sort key");
+		}
+
+		Identifier::State selected = Identifier::Undefined;
+		if(!state.empty()) {
+			selected = Identifier::StateFactory(state.c_str());
+		}
+
+		// Snapshot.
+		std::vector<Row> rows;
+
+		uint64_t generation;
+		{
+			lock_guard<Guard> lock(guard);
+
+			generation = metrics.refreshes.load(memory_order_relaxed);
+			rows.reserve(identifiers.size());
+
+			for(size_t slot = 0; slot < slots.size(); slot++) {
+
+				const Identifier *identifier = slots.owner[slot];
+
+				if(!identifier
+					|| (selected != Identifier::Undefined && slots.state[slot] != selected)
+					|| (!uid.empty() && identifier->getUid() != owner)) {
+					continue;
+				}
+
+				rows.push_back(Row{
+					slots.pid[slot],
+					slots.state[slot],
+					identifier->getCPU(),
+					identifier->getRSS(),
+					identifier->getVSize(),
+					identifier->getUid(),
+					identifier->getExeName()
+				});
+
+			}
+		}
+
+		// Pattern filter, on the copy.
+		if(!exename.empty()) {
+			rows.erase(remove_if(rows.begin(),rows.end(),[&exename](const Row &row){
+				return fnmatch(exename.c_str(),row.exename.c_str(),FNM_CASEFOLD) != 0;
+			}),rows.end());
+		}
+
+		// Sort only up to the end of the page.
+		size_t total = rows.size();
+		size_t first = std::min(offset,total);
+		size_t last = first + std::min(limit,total - first);
+
+		switch(key) {
+		case 0:
+			// The slots are not in pid order.
+			partial_sort(rows.begin(),rows.begin()+last,rows.end(),[](const Row &a, const Row &b){
+				return a.pid < b.pid;
+			});
+			break;
+
+		case 1:
+			partial_sort(rows.begin(),rows.begin()+last,rows.end(),[](const Row &a, const Row &b){
+				return a.cpu > b.cpu || (a.cpu == b.cpu && a.pid < b.pid);
+			});
+			break;
+
+		case 2:
+			partial_sort(rows.begin(),rows.begin()+last,rows.end(),[](const Row &a, const Row &b){
+				return a.rss > b.rss || (a.rss == b.rss && a.pid < b.pid);
+			});
+			break;
+
+		}
+
+		// Page.
+		response["generation"] = (unsigned long long) generation;
+		response["total"] = (unsigned long long) total;
+		response["offset"] = (unsigned long long) first;
+
+		Value &processes = response["processes"];
+		for(size_t ix = first; ix < last; ix++) {
+
+			const Row &row = rows[ix];
+			Value &item = processes[std::to_string(ix+1).c_str()];
+
+			item["pid"] = (unsigned int) row.pid;
+			item["exename"] = row.exename;
+
+			// Processes not refreshed yet have no state.
+			if(row.state != Identifier::Unknown) {
+				item["mode"] = Identifier::StateNameFactory(row.state).name;
+			}
+			item["cpu"].setFraction(row.cpu / 100);
+			item["rss"] = row.rss;
+			item["vsize"] = row.vsize;
+
+		}
+
+	}
+
+ }
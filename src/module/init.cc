@@ -20,6 +20,7 @@
  #include <config.h>
  #include <udjat/agent.h>
  #include <udjat/process/agent.h>
+ #include <controller.h>
  #include <udjat/module.h>
  #include <udjat/factory.h>
  #include <udjat/moduleinfo.h>
@@ -45,6 +46,12 @@
 			return Udjat::Process::Agent::AgentFactory(node);
 		}
 
+		/// @brief Process table, see Process::Controller::get.
+		bool get(Udjat::Request &request, Udjat::Response &response) const override {
+			Udjat::Process::Controller::getInstance().get(request,response);
+			return true;
+		}
+
 
 	};
 
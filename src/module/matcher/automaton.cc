@@ -0,0 +1,126 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * References:
+ *
+ * <https://en.wikipedia.org/wiki/Aho%E2%80%93Corasick_algorithm>
+ *
+ */
+
+ #include <config.h>
+ #include <matcher.h>
+ #include <algorithm>
+ #include <queue>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	Process::Matcher::Automaton::Automaton() {
+		clear();
+	}
+
+	void Process::Matcher::Automaton::clear() {
+		nodes.clear();
+		nodes.emplace_back();	// Root.
+	}
+
+	uint32_t Process::Matcher::Automaton::child(uint32_t node, unsigned char chr) const noexcept {
+
+		const auto &next = nodes[node].next;
+
+		auto it = lower_bound(next.begin(),next.end(),chr,[](const pair<unsigned char,uint32_t> &item, unsigned char chr){
+			return item.first < chr;
+		});
+
+		if(it != next.end() && it->first == chr) {
+			return it->second;
+		}
+
+		return 0;
+
+	}
+
+	void Process::Matcher::Automaton::insert(const std::string &literal, uint32_t id) {
+
+		uint32_t node = 0;
+
+		for(unsigned char chr : literal) {
+
+			uint32_t next = child(node,chr);
+
+			if(!next) {
+
+				next = (uint32_t) nodes.size();
+				nodes.emplace_back();
+
+				auto &items = nodes[node].next;
+				items.insert(
+					upper_bound(items.begin(),items.end(),chr,[](unsigned char chr, const pair<unsigned char,uint32_t> &item){
+						return chr < item.first;
+					}),
+					make_pair(chr,next)
+				);
+
+			}
+
+			node = next;
+		}
+
+		nodes[node].ids.push_back(id);
+
+	}
+
+	void Process::Matcher::Automaton::compile() {
+
+		// Breadth-first, the failure link of a node is always on a lower depth.
+		queue<uint32_t> pending;
+
+		for(auto &item : nodes[0].next) {
+			nodes[item.second].fail = 0;
+			pending.push(item.second);
+		}
+
+		while(!pending.empty()) {
+
+			uint32_t node = pending.front();
+			pending.pop();
+
+			Node &current = nodes[node];
+			current.output = (current.ids.empty() ? nodes[current.fail].output : node);
+
+			for(auto &item : current.next) {
+
+				uint32_t fail = current.fail;
+				uint32_t target;
+				while( !(target = child(fail,item.first)) && fail) {
+					fail = nodes[fail].fail;
+				}
+
+				nodes[item.second].fail = target;
+				pending.push(item.second);
+
+			}
+
+		}
+
+	}
+
+ }
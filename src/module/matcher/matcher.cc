@@ -0,0 +1,287 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+ #include <config.h>
+ #include <matcher.h>
+ #include <algorithm>
+ #include <fnmatch.h>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	const char * Process::Matcher::fieldNames[] = {
+		"exename",
+		"cmdline",
+		"comm"
+	};
+
+	const std::string & Process::Matcher::Subject::operator[](const Field field) {
+
+		if(!loaded[field]) {
+
+			switch(field) {
+			case ExeName:
+				values[field] = identifier.exename();
+				break;
+
+			case CmdLine:
+				values[field] = identifier.cmdline();
+				break;
+
+			case Comm:
+				values[field] = identifier.comm();
+				break;
+
+			}
+
+			loaded[field] = true;
+		}
+
+		return values[field];
+
+	}
+
+	void Process::Matcher::Subject::set(const Field field, std::string &&value) noexcept {
+		values[field] = std::move(value);
+		loaded[field] = true;
+	}
+
+	void Process::Matcher::Subject::release(const Field field) noexcept {
+		std::string().swap(values[field]);
+		loaded[field] = false;
+	}
+
+	Process::Matcher::Pattern::Pattern(Agent *a, Field f, const char *p, const char *e) : agent(a), field(f), pattern(p) {
+		if(e) {
+			exename = e;
+			transform(exename.begin(),exename.end(),exename.begin(),::tolower);
+		}
+	}
+
+	bool Process::Matcher::test(Subject &subject, const Field field, const char *pattern) {
+		return fnmatch(pattern,subject[field].c_str(),(field == ExeName ? FNM_CASEFOLD : 0)) == 0;
+	}
+
+	bool Process::Matcher::literal(const char *pattern, std::string &literal) {
+
+		bool wildcards = false;
+		string current;
+
+		literal.clear();
+
+		for(const char *ptr = pattern; *ptr; ptr++) {
+
+			switch(*ptr) {
+			case '*':
+			case '?':
+				wildcards = true;
+				current.clear();
+				break;
+
+			case '[':
+				// Skip bracket expression.
+				wildcards = true;
+				current.clear();
+				if(ptr[1] == '!' || ptr[1] == '^') {
+					ptr++;
+				}
+				if(ptr[1] == ']') {
+					ptr++;
+				}
+				while(ptr[1] && ptr[1] != ']') {
+					ptr++;
+				}
+				if(ptr[1]) {
+					ptr++;
+				}
+				break;
+
+			case '\\':
+				wildcards = true;
+				if(ptr[1]) {
+					ptr++;
+				}
+				// Fall through
+
+			default:
+				current += (char) tolower(*ptr);
+				if(current.size() > literal.size()) {
+					literal = current;
+				}
+
+			}
+
+		}
+
+		return wildcards;
+
+	}
+
+	void Process::Matcher::insert(Agent *agent, const Field field, const char *pattern, const char *exename) {
+		patterns.emplace_back(agent,field,pattern,exename);
+		dirty = true;
+	}
+
+	void Process::Matcher::remove(const Agent *agent) {
+
+		patterns.erase(
+			remove_if(patterns.begin(),patterns.end(),[agent](const Pattern &pattern){
+				return pattern.agent == agent;
+			}),
+			patterns.end()
+		);
+
+		dirty = true;
+	}
+
+	void Process::Matcher::compile() {
+
+		for(auto &item : compiled) {
+			item.automaton.clear();
+			item.exact.clear();
+			item.always.clear();
+		}
+		filtered.clear();
+
+		string text;
+		for(uint32_t id = 0; id < (uint32_t) patterns.size(); id++) {
+
+			const Pattern &pattern = patterns[id];
+			auto &target = compiled[pattern.field];
+
+			if(!pattern.exename.empty()) {
+
+				// Tested only after an exename hit.
+				filtered.emplace(pattern.exename,id);
+
+			} else if(!literal(pattern.pattern.c_str(),text)) {
+
+				// No wildcards, exact match.
+				if(pattern.field == ExeName) {
+					target.exact.emplace(text,id);
+				} else {
+					target.exact.emplace(pattern.pattern,id);
+				}
+
+			} else if(text.empty()) {
+
+				target.always.push_back(id);
+
+			} else {
+
+				target.automaton.insert(text,id);
+
+			}
+
+		}
+
+		for(auto &item : compiled) {
+			item.automaton.compile();
+		}
+
+		marks.assign(patterns.size(),0);
+		generation = 0;
+		dirty = false;
+
+	}
+
+	void Process::Matcher::probe(Subject &subject, std::vector<Agent *> &agents) {
+
+		if(dirty) {
+			compile();
+		}
+
+		if(!++generation) {
+			// Wrapped, reset marks.
+			fill(marks.begin(),marks.end(),0);
+			generation = 1;
+		}
+
+		// Patterns with exename prefilter, the other properties are read
+		// only for the processes with a matching exename.
+		if(!filtered.empty()) {
+
+			string key{subject[ExeName]};
+			transform(key.begin(),key.end(),key.begin(),::tolower);
+
+			auto range = filtered.equal_range(key);
+			for(auto it = range.first; it != range.second; it++) {
+				const Pattern &pattern = patterns[it->second];
+				if(test(subject,pattern.field,pattern.pattern.c_str())) {
+					agents.push_back(pattern.agent);
+				}
+			}
+
+		}
+
+		for(size_t field = 0; field < FieldCount; field++) {
+
+			const auto &target = compiled[field];
+
+			if(target.empty()) {
+				continue;
+			}
+
+			const string &value = subject[(Field) field];
+
+			// Exact patterns.
+			if(!target.exact.empty()) {
+
+				string key{value};
+				if(field == ExeName) {
+					transform(key.begin(),key.end(),key.begin(),::tolower);
+				}
+
+				auto range = target.exact.equal_range(key);
+				for(auto it = range.first; it != range.second; it++) {
+					agents.push_back(patterns[it->second].agent);
+				}
+
+			}
+
+			// Wildcard patterns with a literal found in the value.
+			auto verify = [this,&subject,&agents](uint32_t id) {
+
+				if(marks[id] == generation) {
+					return;
+				}
+				marks[id] = generation;
+
+				const Pattern &pattern = patterns[id];
+				if(test(subject,pattern.field,pattern.pattern.c_str())) {
+					agents.push_back(pattern.agent);
+				}
+
+			};
+
+			target.automaton.search(value,verify);
+
+			for(auto id : target.always) {
+				verify(id);
+			}
+
+		}
+
+		// Command lines can be large, don't keep them after the match.
+		subject.release(CmdLine);
+
+	}
+
+ }
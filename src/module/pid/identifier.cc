@@ -18,13 +18,20 @@
  */
 
  #include <controller.h>
+ #include <tracepoints.h>
  #include <unistd.h>
  #include <string>
  #include <sys/types.h>
  #include <sys/stat.h>
  #include <fcntl.h>
  #include <udjat/tools/intl.h>
+ #include <udjat/tools/configuration.h>
+ #include <udjat/tools/quark.h>
  #include <iostream>
+ #include <fstream>
+ #include <algorithm>
+ #include <cstring>
+ #include <atomic>
 
  using namespace std;
 
@@ -80,23 +87,97 @@
 		throw runtime_error("Invalid or unexpected process state name");
 	}
 
+	/// @brief The procfs path, interned; previous values stay valid when it changes.
+	static std::atomic<const char *> procfs_path{nullptr};
+
+	const char * Process::Identifier::procfs() {
+
+		const char *path = procfs_path.load(memory_order_acquire);
+
+		if(!path) {
+
+			// First call, from the controller start; keep a path set meanwhile.
+			string value = Config::Value<string>("process","procfs","/proc").get();
+			const char *configured = Quark(value.c_str()).c_str();
+			if(procfs_path.compare_exchange_strong(path,configured,memory_order_acq_rel)) {
+				path = configured;
+			}
+
+		}
+
+		return path;
+
+	}
+
+	void Process::Identifier::procfs(const char *path) {
+		procfs_path.store(Quark(path).c_str(),memory_order_release);
+	}
+
+	Process::Identifier::Identifier(pid_t p) : pid(p), starttime(StartTime(p)) {
+	}
+
 	Process::Identifier::~Identifier() {
 		set(Dead);
 	}
 
+	bool Process::Identifier::valid() const noexcept {
+		return starttime && StartTime(pid) == starttime;
+	}
+
+	time_t Process::Identifier::started() const {
+
+		// Thread safe initialization, retried on the next call if it throws.
+		static const time_t boottime = []() {
+
+			time_t value = 0;
+
+			ifstream stat;
+			Controller::metrics.read();
+			stat.open(string{procfs()} + "/stat");
+
+			string name;
+			while(stat >> name) {
+				if(name == "btime") {
+					stat >> value;
+					break;
+				}
+				stat.ignore(numeric_limits<streamsize>::max(),'\n');
+			}
+
+			if(!value) {
+				throw runtime_error("Can't get boot time from /proc/stat");
+			}
+
+			return value;
+
+		}();
+
+		return boottime + (time_t) (starttime / sysconf(_SC_CLK_TCK));
+
+	}
+
 	std::string Process::Identifier::exename() const {
+		return exename(pid);
+	}
+
+	std::string Process::Identifier::exename(pid_t pid) {
 
-		string pathname{"/proc/"};
+		string pathname{procfs()};
+		pathname += "/";
 		pathname += std::to_string((unsigned int) pid) + "/exe";
 
 		char name[4096];
 
+		Controller::metrics.read();
 		ssize_t sz = readlink(pathname.c_str(), name, 4095);
 		if(sz > 0) {
 			name[sz] = 0;
 		} else {
 #ifndef DEBUG
-			cerr << "Error '" << strerror(errno) << "' getting exename for pid " << pid << endl;
+			// Kernel threads have no executable and the process can be gone, both expected.
+			if(errno != ENOENT && errno != ESRCH) {
+				cerr << "Error '" << strerror(errno) << "' getting exename for pid " << pid << endl;
+			}
 #endif // DEBUG
 			return string{"pid"} + std::to_string((unsigned int) pid);
 		}
@@ -105,6 +186,109 @@
 
 	}
 
+	std::string Process::Identifier::cmdline() const {
+		return cmdline(pid);
+	}
+
+	std::string Process::Identifier::cmdline(pid_t pid) {
+
+		string pathname{procfs()};
+		pathname += "/";
+		pathname += std::to_string((unsigned int) pid) + "/cmdline";
+
+		Controller::metrics.read();
+		int fd = open(pathname.c_str(),O_RDONLY);
+		if(fd < 0) {
+			return string{};
+		}
+
+		string text;
+		char buffer[4096];
+		ssize_t sz;
+		while( (sz = read(fd,buffer,sizeof(buffer))) > 0) {
+			text.append(buffer,sz);
+		}
+		::close(fd);
+
+		// Arguments are separated by NUL, replace them with spaces.
+		while(!text.empty() && text.back() == 0) {
+			text.pop_back();
+		}
+		replace(text.begin(),text.end(),'\0',' ');
+
+		return text;
+
+	}
+
+	uid_t Process::Identifier::uid(pid_t pid) noexcept {
+
+		// The /proc/pid owner is the effective uid (root for non dumpable
+		// processes), the real one is the first field of 'Uid:' on status.
+		char buffer[4096];
+
+		try {
+			// No allocations; procfs() throws only before the controller resolves it.
+			snprintf(buffer,sizeof(buffer),"%s/%u/status",procfs(),(unsigned int) pid);
+		} catch(...) {
+			return (uid_t) -1;
+		}
+
+		Controller::metrics.read();
+		int fd = open(buffer,O_RDONLY);
+		if(fd < 0) {
+			return (uid_t) -1;
+		}
+
+		ssize_t sz = read(fd,buffer,sizeof(buffer)-1);
+		::close(fd);
+
+		if(sz <= 0) {
+			return (uid_t) -1;
+		}
+
+		buffer[sz] = 0;
+
+		const char *ptr = strstr(buffer,"\nUid:");
+		if(!ptr) {
+			return (uid_t) -1;
+		}
+
+		return (uid_t) strtoul(ptr+5,nullptr,10);
+
+	}
+
+	std::string Process::Identifier::comm() const {
+		return comm(pid);
+	}
+
+	std::string Process::Identifier::comm(pid_t pid) {
+
+		string pathname{procfs()};
+		pathname += "/";
+		pathname += std::to_string((unsigned int) pid) + "/comm";
+
+		Controller::metrics.read();
+		int fd = open(pathname.c_str(),O_RDONLY);
+		if(fd < 0) {
+			return string{};
+		}
+
+		char name[64];
+		ssize_t sz = read(fd,name,sizeof(name)-1);
+		::close(fd);
+
+		if(sz <= 0) {
+			return string{};
+		}
+
+		if(name[sz-1] == '\n') {
+			sz--;
+		}
+
+		return string{name,(size_t) sz};
+
+	}
+
 	void Process::Identifier::reset() {
 		set(Undefined);
 		cpu.percent = 0;
@@ -115,13 +299,15 @@
 		if(state == this->state)
 			return;
 
+		PROCESS_PROBE3(state,pid,(unsigned int) this->state,(unsigned int) state);
+
 		this->state = state;
 
 	}
 
 	Process::Identifier::State Process::Identifier::getState() {
 
-		if(state == (State) -1) {
+		if(state == Unknown) {
 
 			// No state, get it.
 			set( (State) Stat(this).state);
@@ -20,6 +20,7 @@
  #include <config.h>
  #include <controller.h>
  #include <string>
+ #include <cstdio>
  #include <sys/types.h>
  #include <sys/stat.h>
  #include <fcntl.h>
@@ -280,7 +281,8 @@
 		// https://github.com/mmcilroy/cpu_usage
 		char buffer[4096];
 
-		int fd = open((string{"/proc/"} + std::to_string(pid) + "/stat").c_str(),O_RDONLY);
+		Controller::metrics.read();
+		int fd = open((string{procfs()} + "/" + std::to_string(pid) + "/stat").c_str(),O_RDONLY);
 		if(fd <  0) {
 
 			if(errno == ENOENT) {
@@ -368,6 +370,50 @@
 
 	}
 
+	unsigned long long Process::Identifier::StartTime(pid_t pid) noexcept {
+
+		char buffer[4096];
+
+		try {
+			// No allocations; procfs() throws only before the controller resolves it.
+			snprintf(buffer,sizeof(buffer),"%s/%u/stat",procfs(),(unsigned int) pid);
+		} catch(...) {
+			return 0;
+		}
+
+		Controller::metrics.read();
+		int fd = open(buffer,O_RDONLY);
+		if(fd < 0) {
+			return 0;
+		}
+
+		ssize_t szBuffer = read(fd,buffer,sizeof(buffer)-1);
+		::close(fd);
+
+		if(szBuffer < 1) {
+			return 0;
+		}
+
+		buffer[szBuffer] = 0;
+
+		const char *ptr = strrchr(buffer,')');
+		if(!ptr) {
+			return 0;
+		}
+		ptr++;
+
+		// Skip fields 3 (state) to 21 (itrealvalue), starttime is the 22th.
+		for(size_t field = 3; field < 22; field++) {
+			while(*ptr == ' ')
+				ptr++;
+			while(*ptr && *ptr != ' ')
+				ptr++;
+		}
+
+		return strtoull(ptr,NULL,10);
+
+	}
+
 	unsigned long long Process::Identifier::Stat::getRSS() const {
 
 		// https://stackoverflow.com/questions/669438/how-to-get-memory-usage-at-runtime-using-c
@@ -0,0 +1,238 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ #include <config.h>
+ #include <recorder.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <system_error>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	/// @brief Frame decoder, throws on truncated frames.
+	class Decoder {
+	private:
+		const uint8_t *ptr;
+		const uint8_t *end;
+
+	public:
+		Decoder(const vector<uint8_t> &frame) : ptr(frame.data()), end(frame.data() + frame.size()) {
+		}
+
+		uint8_t byte() {
+			if(ptr >= end) {
+				throw runtime_error("Truncated recording frame");
+			}
+			return *(ptr++);
+		}
+
+		uint64_t varint() {
+			uint64_t value = 0;
+			for(unsigned int shift = 0; shift < 64; shift += 7) {
+				uint8_t chr = byte();
+				value |= ((uint64_t) (chr & 0x7f)) << shift;
+				if(!(chr & 0x80)) {
+					return value;
+				}
+			}
+			throw runtime_error("Invalid varint on recording frame");
+		}
+
+		int64_t zigzag() {
+			uint64_t value = varint();
+			return (int64_t) (value >> 1) ^ -((int64_t) (value & 1));
+		}
+
+		void string(std::string &value) {
+			size_t length = (size_t) varint();
+			if((size_t) (end - ptr) < length) {
+				throw runtime_error("Truncated recording frame");
+			}
+			value.assign((const char *) ptr,length);
+			ptr += length;
+		}
+
+	};
+
+	Process::Recording::Reader::Reader(const char *path) {
+
+		fd = ::open(path,O_RDONLY|O_CLOEXEC);
+		if(fd < 0) {
+			throw system_error(errno,system_category(),path);
+		}
+
+		if(pread(fd,&header,sizeof(header),0) != sizeof(header) || header.magic != Magic || header.version != Version || !header.pagesize) {
+			::close(fd);
+			throw runtime_error(std::string{"Invalid recording "} + path);
+		}
+
+		remaining = header.frames;
+		offset = header.head;
+
+	}
+
+	Process::Recording::Reader::~Reader() {
+		::close(fd);
+	}
+
+	bool Process::Recording::Reader::load() {
+
+		while(remaining) {
+
+			uint32_t length = 0;
+
+			if(header.size - offset >= sizeof(length)) {
+				if(pread(fd,&length,sizeof(length),sizeof(header) + offset) != sizeof(length)) {
+					throw system_error(errno,system_category(),"Can't read recording");
+				}
+			}
+
+			if(!length) {
+				// End of the used ring.
+				if(!offset) {
+					throw runtime_error("Invalid recording ring");
+				}
+				offset = 0;
+				continue;
+			}
+
+			if(offset + sizeof(length) + length > header.size) {
+				throw runtime_error("Invalid recording frame length");
+			}
+
+			frame.resize(length);
+			if(pread(fd,frame.data(),length,sizeof(header) + offset + sizeof(length)) != (ssize_t) length) {
+				throw system_error(errno,system_category(),"Can't read recording");
+			}
+
+			offset += sizeof(length) + length;
+			remaining--;
+			return true;
+
+		}
+
+		return false;
+
+	}
+
+	bool Process::Recording::Reader::read(Generation &generation) {
+
+		generation.clear();
+
+		// Frames before the first key frame are relative to evicted ones.
+		do {
+
+			if(!load()) {
+				return false;
+			}
+
+			synced = synced || (frame.front() & Key);
+
+		} while(!synced);
+
+		Decoder decoder{frame};
+
+		generation.key = (decoder.byte() & Key);
+		generation.number = decoder.varint();
+		generation.timestamp = decoder.varint();
+		generation.running = decoder.varint();
+		generation.idle = decoder.varint();
+
+		if(generation.key) {
+			last.clear();
+		}
+
+		// Removed pids.
+		{
+			size_t count = (size_t) decoder.varint();
+			generation.removed.resize(count);
+
+			pid_t pid = 0;
+			for(auto &removed : generation.removed) {
+				pid += (pid_t) decoder.varint();
+				removed = pid;
+				last.erase(pid);
+			}
+		}
+
+		// Spawned processes.
+		{
+			size_t count = (size_t) decoder.varint();
+			generation.spawned.resize(count);
+
+			pid_t pid = 0;
+			for(auto &spawn : generation.spawned) {
+				pid += (pid_t) decoder.varint();
+				spawn.pid = pid;
+				last[pid] = Last{};
+			}
+
+			for(auto &spawn : generation.spawned) {
+				spawn.starttime = decoder.varint();
+			}
+
+			for(size_t field = 0; field < Matcher::FieldCount; field++) {
+				for(auto &spawn : generation.spawned) {
+					decoder.string(spawn.values[field]);
+				}
+			}
+		}
+
+		// Changed processes.
+		{
+			size_t count = (size_t) decoder.varint();
+			generation.changed.resize(count);
+
+			pid_t pid = 0;
+			for(auto &sample : generation.changed) {
+				pid += (pid_t) decoder.varint();
+				sample.pid = pid;
+			}
+
+			for(auto &sample : generation.changed) {
+				sample.state = (Identifier::State) decoder.byte();
+			}
+
+			for(auto &sample : generation.changed) {
+				auto &values = last[sample.pid];
+				values.ticks = (unsigned long) ((int64_t) values.ticks + decoder.zigzag());
+				sample.ticks = values.ticks;
+			}
+
+			for(auto &sample : generation.changed) {
+				auto &values = last[sample.pid];
+				values.pages = (uint64_t) ((int64_t) values.pages + decoder.zigzag());
+				sample.rss = values.pages * header.pagesize;
+			}
+
+			for(auto &sample : generation.changed) {
+				auto &values = last[sample.pid];
+				values.vpages = (uint64_t) ((int64_t) values.vpages + decoder.zigzag());
+				sample.vsize = values.vpages * header.pagesize;
+			}
+		}
+
+		return true;
+
+	}
+
+ }
@@ -0,0 +1,376 @@
+/* SPDX-License-Identifier: LGPL-3.0-or-later */
+
+/*
+ * Copyright (C) 2021 Perry Werneck <perry.werneck@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+ #include <config.h>
+ #include <recorder.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <chrono>
+ #include <cstring>
+ #include <iostream>
+ #include <algorithm>
+ #include <system_error>
+
+ using namespace std;
+
+ namespace Udjat {
+
+	static inline void put(vector<uint8_t> &frame, uint64_t value) {
+		while(value >= 0x80) {
+			frame.push_back((uint8_t) (value | 0x80));
+			value >>= 7;
+		}
+		frame.push_back((uint8_t) value);
+	}
+
+	static inline void put(vector<uint8_t> &frame, int64_t value) {
+		put(frame,(((uint64_t) value) << 1) ^ (uint64_t) (value >> 63));
+	}
+
+	static inline void put(vector<uint8_t> &frame, const string &value) {
+		put(frame,(uint64_t) value.size());
+		frame.insert(frame.end(),value.begin(),value.end());
+	}
+
+	void Process::Recording::Generation::clear() noexcept {
+		key = false;
+		removed.clear();
+		spawned.clear();
+		changed.clear();
+	}
+
+	Process::Recording::Writer::Writer(const char *path, uint64_t size, unsigned int k) : keyframe(k ? k : 1) {
+
+		fd = ::open(path,O_RDWR|O_CREAT|O_CLOEXEC,0644);
+		if(fd < 0) {
+			throw system_error(errno,system_category(),path);
+		}
+
+		// Continue a previous recording with the same layout.
+		if(pread(fd,&header,sizeof(header),0) == sizeof(header)
+				&& header.magic == Magic
+				&& header.version == Version
+				&& header.size == size
+				&& header.pagesize == (uint32_t) sysconf(_SC_PAGESIZE)) {
+			return;
+		}
+
+		memset(&header,0,sizeof(header));
+		header.magic = Magic;
+		header.version = Version;
+		header.size = size;
+		header.pagesize = (uint32_t) sysconf(_SC_PAGESIZE);
+
+		if(ftruncate(fd,0) || ftruncate(fd,sizeof(header) + size) || pwrite(fd,&header,sizeof(header),0) != sizeof(header)) {
+			int err = errno;
+			::close(fd);
+			throw system_error(err,system_category(),path);
+		}
+
+	}
+
+	Process::Recording::Writer::~Writer() {
+		::close(fd);
+	}
+
+	void Process::Recording::Writer::evict() {
+
+		uint32_t length = 0;
+
+		if(header.size - header.head >= sizeof(length)) {
+			if(pread(fd,&length,sizeof(length),sizeof(header) + header.head) != sizeof(length)) {
+				throw system_error(errno,system_category(),"Can't read recording");
+			}
+		}
+
+		if(!length) {
+			// End of the used ring.
+			header.head = 0;
+			return;
+		}
+
+		header.head += sizeof(length) + length;
+		header.frames--;
+
+		if(!header.frames) {
+			header.head = header.tail;
+		}
+
+	}
+
+	void Process::Recording::Writer::append() {
+
+		uint32_t length = (uint32_t) work.frame.size();
+		uint64_t required = sizeof(length) + length;
+
+		if(required > header.size) {
+			throw runtime_error("Generation is larger than the recording");
+		}
+
+		if(!header.frames) {
+			header.head = header.tail;
+		}
+
+		if(header.tail + required > header.size) {
+
+			// Frames after the tail are overwritten on this lap.
+			while(header.frames && header.head >= header.tail) {
+				evict();
+			}
+
+			// Mark the end of the used ring and wrap.
+			if(header.size - header.tail >= sizeof(length)) {
+				static const uint32_t marker = 0;
+				if(pwrite(fd,&marker,sizeof(marker),sizeof(header) + header.tail) != sizeof(marker)) {
+					throw system_error(errno,system_category(),"Can't write recording");
+				}
+			}
+
+			header.tail = 0;
+
+			if(!header.frames) {
+				header.head = 0;
+			}
+
+		}
+
+		while(header.frames && header.head >= header.tail && header.head < header.tail + required) {
+			evict();
+		}
+
+		if(!header.frames) {
+			header.head = header.tail;
+		}
+
+		if(pwrite(fd,&length,sizeof(length),sizeof(header) + header.tail) != sizeof(length)
+				|| pwrite(fd,work.frame.data(),length,sizeof(header) + header.tail + sizeof(length)) != (ssize_t) length) {
+			throw system_error(errno,system_category(),"Can't write recording");
+		}
+
+		header.tail += required;
+		header.frames++;
+
+		if(pwrite(fd,&header,sizeof(header),0) != sizeof(header)) {
+			throw system_error(errno,system_category(),"Can't write recording header");
+		}
+
+	}
+
+	bool Process::Recording::Writer::known(pid_t pid, unsigned long long starttime) const noexcept {
+		auto it = last.find(pid);
+		return it != last.end() && it->second.starttime == starttime;
+	}
+
+	void Process::Recording::Writer::exited(pid_t pid) {
+		lock_guard<mutex> lock(exits.guard);
+		exits.pids.push_back(pid);
+	}
+
+	void Process::Recording::Writer::write(uint64_t number, unsigned long long running, unsigned long long idle, std::vector<Entry> &entries) {
+
+		bool key = (!since || since >= keyframe);
+		if(key) {
+			since = 0;
+		}
+
+		sort(entries.begin(),entries.end(),[](const Entry &a, const Entry &b){
+			return a.sample.pid < b.sample.pid;
+		});
+
+		epoch++;
+
+		work.removed.clear();
+		work.spawned.clear();
+		work.changed.clear();
+
+		// Dropped now, the pids can be reused on this generation.
+		{
+			lock_guard<mutex> lock(exits.guard);
+			work.exited.swap(exits.pids);
+		}
+
+		for(auto pid : work.exited) {
+			if(last.erase(pid)) {
+				work.removed.push_back(pid);
+			}
+		}
+		work.exited.clear();
+
+		uint64_t pagesize = header.pagesize;
+
+		for(const Entry &entry : entries) {
+
+			const Sample &sample = entry.sample;
+			uint64_t pages = sample.rss / pagesize;
+			uint64_t vpages = sample.vsize / pagesize;
+
+			auto it = last.find(sample.pid);
+
+			if(it == last.end() || it->second.starttime != entry.starttime) {
+
+				// New process, or the pid was reused.
+				if(it == last.end()) {
+					it = last.emplace(sample.pid,Last{}).first;
+				}
+
+				// The exename comes from the identifier, the controller isn't locked here.
+				Last &values = it->second;
+				values.starttime = entry.starttime;
+				values.values[Matcher::ExeName] = (entry.exename.empty() ? Identifier::exename(sample.pid) : entry.exename);
+				values.values[Matcher::CmdLine] = Identifier::cmdline(sample.pid);
+				values.values[Matcher::Comm] = Identifier::comm(sample.pid);
+
+			} else if(!key) {
+
+				it->second.epoch = epoch;
+
+				if(it->second.state != sample.state || it->second.ticks != sample.ticks || it->second.pages != pages || it->second.vpages != vpages) {
+					work.changed.push_back(&entry);
+				}
+
+				continue;
+
+			}
+
+			// Deltas are relative to zero.
+			it->second.state = Identifier::Undefined;
+			it->second.ticks = 0;
+			it->second.pages = 0;
+			it->second.vpages = 0;
+			it->second.epoch = epoch;
+
+			work.spawned.push_back(&entry);
+			work.changed.push_back(&entry);
+
+		}
+
+		for(auto it = last.begin(); it != last.end();) {
+			if(it->second.epoch != epoch) {
+				work.removed.push_back(it->first);
+				it = last.erase(it);
+			} else {
+				it++;
+			}
+		}
+
+		if(key) {
+			// The reader starts from an empty table.
+			work.removed.clear();
+		}
+
+		sort(work.removed.begin(),work.removed.end());
+
+		//
+		// Encode.
+		//
+		auto &frame = work.frame;
+		frame.clear();
+
+		frame.push_back(key ? Key : 0);
+		put(frame,number);
+		put(frame,(uint64_t) chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count());
+		put(frame,(uint64_t) running);
+		put(frame,(uint64_t) idle);
+
+		// Removed pids.
+		{
+			put(frame,(uint64_t) work.removed.size());
+			pid_t previous = 0;
+			for(auto pid : work.removed) {
+				put(frame,(uint64_t) (pid - previous));
+				previous = pid;
+			}
+		}
+
+		// Spawned processes.
+		{
+			put(frame,(uint64_t) work.spawned.size());
+
+			pid_t previous = 0;
+			for(auto entry : work.spawned) {
+				put(frame,(uint64_t) (entry->sample.pid - previous));
+				previous = entry->sample.pid;
+			}
+
+			for(auto entry : work.spawned) {
+				put(frame,(uint64_t) last[entry->sample.pid].starttime);
+			}
+
+			for(size_t field = 0; field < Matcher::FieldCount; field++) {
+				for(auto entry : work.spawned) {
+					put(frame,last[entry->sample.pid].values[field]);
+				}
+			}
+
+		}
+
+		// Changed processes.
+		{
+			put(frame,(uint64_t) work.changed.size());
+
+			pid_t previous = 0;
+			for(auto entry : work.changed) {
+				put(frame,(uint64_t) (entry->sample.pid - previous));
+				previous = entry->sample.pid;
+			}
+
+			for(auto entry : work.changed) {
+				frame.push_back((uint8_t) entry->sample.state);
+			}
+
+			for(auto entry : work.changed) {
+				Last &values = last[entry->sample.pid];
+				put(frame,(int64_t) entry->sample.ticks - (int64_t) values.ticks);
+				values.ticks = entry->sample.ticks;
+			}
+
+			for(auto entry : work.changed) {
+				Last &values = last[entry->sample.pid];
+				uint64_t pages = entry->sample.rss / pagesize;
+				put(frame,(int64_t) pages - (int64_t) values.pages);
+				values.pages = pages;
+			}
+
+			for(auto entry : work.changed) {
+				Last &values = last[entry->sample.pid];
+				uint64_t vpages = entry->sample.vsize / pagesize;
+				put(frame,(int64_t) vpages - (int64_t) values.vpages);
+				values.vpages = vpages;
+				values.state = entry->sample.state;
+			}
+
+		}
+
+		try {
+
+			append();
+			since++;
+
+		} catch(...) {
+
+			// The reader can't decode the next deltas, restart from a key frame.
+			since = 0;
+			throw;
+
+		}
+
+	}
+
+ }
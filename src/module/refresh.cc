@@ -18,6 +18,7 @@
  */
 
  #include <controller.h>
+ #include <tracepoints.h>
  #include <unistd.h>
  #include <string>
  #include <sys/types.h>
@@ -26,6 +27,8 @@
  #include <udjat/tools/system/stat.h>
  #include <udjat/tools/threadpool.h>
  #include <iostream>
+ #include <algorithm>
+ #include <cmath>
 
  using namespace std;
 
@@ -33,7 +36,22 @@
 
 	void Process::Controller::refresh() noexcept {
 
-		lock_guard<recursive_mutex> lock(guard);
+		scan();
+
+		if(recorder) {
+			record();
+		}
+
+	}
+
+	void Process::Controller::scan() noexcept {
+
+		lock_guard<Guard> lock(guard);
+
+		auto begin = chrono::steady_clock::now();
+		auto files = metrics.files.load(memory_order_relaxed);
+
+		PROCESS_PROBE1(refresh_start,identifiers.size());
 
 		try {
 
@@ -59,90 +77,251 @@
 			cout << "Total CPU usage: " << (sysusage*100) << "%" << endl;
 #endif // DEBUG
 
-			if (update.cpu_use_per_process) {
-
-				//
-				// Get CPU usage by pid.
-				//
+			// Identifiers whose pid no longer refers to the same process.
+			auto &stale = work.stale;
+			stale.clear();
 
-				struct Entry {
+			// Processes with agents, and the values before the refresh.
+			auto &bound = work.bound;
+			bound.clear();
 
-					Identifier &info;
-					float usage;
+			const size_t count = slots.size();
 
-					Entry(Identifier &i, float u) : info(i), usage(u) {
-					}
+			// Update Process stats; the same read validates the process, so state
+			// and memory are updated even without per process CPU usage.
+			float totaltime = 0;
+			for(size_t slot = 0; slot < count; slot++) {
 
-				};
+				Identifier *ix = slots.owner[slot];
 
-				list<Entry> pids;
+				slots.delta[slot] = 0;
 
-				// Update Process stats.
-				float totaltime = 0;
-				for(auto ix = identifiers.begin(); ix != identifiers.end(); ix++) {
+				if(!ix) {
+					continue;
+				}
 
-					Identifier::Stat stat(*ix);
+				Identifier::Stat stat(slots.pid[slot]);
 
-					ix->set((Identifier::State) stat.state);
+				if(!ix->starttime || stat.starttime != ix->starttime) {
+					// Pid was reused, the process is gone and the EXIT event was lost,
+					// or the start time is unknown (0, a failed read) and must be read again.
+					stale.push_back(slots.pid[slot]);
+					continue;
+				}
 
-					unsigned long time = (stat.utime + stat.stime);
+				Identifier::State state = (Identifier::State) stat.state;
 
-					if(time) {
+				if(!ix->agents.empty()) {
+					bound.push_back(Bound{ix,ix->getCPU(),ix->rss,state != slots.state[slot]});
+				}
 
-						float current = 0;
+				if(state != slots.state[slot] && !subscriptions.transitions.empty()) {
+					transition(*ix,slots.state[slot],state);
+				}
 
-						if(ix->cpu.last && time > ix->cpu.last) {
+				slots.state[slot] = state;
+				ix->set(state);
 
-							current = (float) (time - ix->cpu.last);
-							totaltime += (float) current;
-							pids.emplace_back(*ix, current);
+				ix->rss = stat.getRSS();
+				ix->vsize = stat.getVSize();
 
-						} else {
+				ix->iowait.delta = (ix->iowait.last && stat.blkio_ticks > ix->iowait.last) ? (stat.blkio_ticks - ix->iowait.last) : 0;
+				ix->iowait.last = stat.blkio_ticks;
 
-							ix->cpu.percent = 0;
+				if(!update.cpu_use_per_process) {
+					continue;
+				}
 
-						}
+				unsigned long time = (stat.utime + stat.stime);
 
-						ix->cpu.last = time;
+				if(time && slots.ticks[slot] && time > slots.ticks[slot]) {
+					slots.delta[slot] = (float) (time - slots.ticks[slot]);
+					totaltime += slots.delta[slot];
+				}
 
-					} else {
-						ix->cpu.last = 0;
-						ix->cpu.percent = 0;
-					}
+				slots.ticks[slot] = time;
 
-				}
+			}
 
 #ifdef DEBUG
-				cout << "Total time=" << totaltime << " pids=" << pids.size() << endl;
+			cout << "Total time=" << totaltime << " pids=" << identifiers.size() << endl;
 #endif // DEBUG
 
-				if(sysusage && totaltime) {
+			if (update.cpu_use_per_process) {
+				evaluate(sysusage,totaltime);
+			} else {
+				report();
+			}
 
-#ifdef DEBUG
-					cout << "Updating usage by pid" << endl;
-#endif // DEBUG
+			for(auto pid : stale) {
+				remove(pid);
+				if(Identifier::StartTime(pid)) {
+					insert(pid);
+				}
+			}
 
-					for(auto ix = pids.begin(); ix != pids.end(); ix++) {
-						ix->info.cpu.percent = (sysusage * ix->usage) / totaltime;
-					}
+			if(shared.header) {
+				publish(sysusage);
+			}
+
+			sample();
+
+		} catch(const exception &e) {
+
+			cerr << "Error '" << e.what() << "' while updating process info" << endl;
+
+		}
+
+		metrics.refreshes.fetch_add(1,memory_order_relaxed);
+		metrics.cycle.store(metrics.files.load(memory_order_relaxed) - files,memory_order_relaxed);
+		metrics.duration.store(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - begin).count(),memory_order_relaxed);
+
+		PROCESS_PROBE2(refresh_end,metrics.duration.load(memory_order_relaxed),identifiers.size());
+
+	}
+
+	void Process::Controller::evaluate(float sysusage, float totaltime) noexcept {
+
+		lock_guard<Guard> lock(guard);
+
+		const size_t count = slots.size();
 
+		// Usage by pid, free slots have no delta.
+		{
+			const float scale = (sysusage && totaltime) ? (sysusage / totaltime) : 0;
+			const float * __restrict__ delta = slots.delta.data();
+			float * __restrict__ percent = slots.percent.data();
 
+			for(size_t slot = 0; slot < count; slot++) {
+				percent[slot] = delta[slot] * scale;
+			}
+
+			for(size_t slot = 0; slot < count; slot++) {
+				if(slots.owner[slot]) {
+					slots.owner[slot]->cpu.percent = percent[slot];
 				}
 			}
+		}
 
-			// Update agents.
-			ThreadPool::getInstance().push([this]() {
-				for(auto agent : agents) {
-					agent->updated(true);
+		report();
+
+	}
+
+	void Process::Controller::report() noexcept {
+
+		lock_guard<Guard> lock(guard);
+
+		for(auto &entry : work.bound) {
+
+			Identifier &info = *entry.info;
+			float cpu = info.getCPU();
+
+			if(cpu != entry.cpu || info.rss != entry.rss) {
+				for(auto agent : info.agents) {
+					agent->changed(info,entry.cpu,entry.rss);
 				}
-			});
+			}
 
-		} catch(const exception &e) {
+			// Notify agents only on meaningful changes since the last notification.
+			if(entry.state
+				|| fabs(cpu - info.notified.cpu) >= update.cpu_delta
+				|| (info.rss > info.notified.rss ? info.rss - info.notified.rss : info.notified.rss - info.rss) >= update.rss_delta) {
 
-			cerr << "Error '" << e.what() << "' while updating process info" << endl;
+				info.notified.cpu = cpu;
+				info.notified.rss = info.rss;
+
+				for(auto agent : info.agents) {
+					notify(agent);
+				}
+
+			}
+
+		}
+
+	}
+
+	void Process::Controller::sample() noexcept {
+
+		lock_guard<Guard> lock(guard);
+
+		// Update agent histories.
+		for(auto agent : agents) {
+
+			agent->sample();
+
+			// Time dependent states need evaluation on every cycle.
+			if(agent->timed) {
+				notify(agent);
+			}
+
+		}
+
+		// Update agents.
+		flush();
+
+	}
+
+	void Process::Controller::flush() {
+
+		lock_guard<Guard> lock(guard);
 
+		if(notifying || pending.empty()) {
+			return;
 		}
 
+		notifying = true;
+
+		ThreadPool::getInstance().push([this]() {
+
+			// Agents are notified without the lock, remove() clears them from
+			// the batch and waits for the one on updated().
+			for(;;) {
+
+				{
+					lock_guard<Guard> lock(guard);
+
+					batch.clear();
+
+					if(pending.empty()) {
+						notifying = false;
+						return;
+					}
+
+					// Both keep their storage.
+					batch.swap(pending);
+					notifier = this_thread::get_id();
+
+					sort(batch.begin(),batch.end());
+					batch.erase(unique(batch.begin(),batch.end()),batch.end());
+				}
+
+				for(size_t ix = 0;; ix++) {
+
+					Agent *agent;
+
+					{
+						lock_guard<Guard> lock(guard);
+
+						if(ix >= batch.size()) {
+							break;
+						}
+
+						agent = batch[ix];
+						if(!agent) {
+							continue;
+						}
+
+						current.store(agent);
+					}
+
+					agent->updated(true);
+					current.store(nullptr);
+
+				}
+
+			}
+
+		});
 
 	}
 